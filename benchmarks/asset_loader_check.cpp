@@ -0,0 +1,143 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "stb_image.h"
+
+#include "AssetLoader.hpp"
+#include "JobSystem.hpp"
+
+// Decodes one asset through AssetLoader on a single worker JobSystem and
+// reads it back with GetImageMip, comparing it with a direct stb_image
+// decode. Then cooks a .tex container next to a copy of the asset and
+// checks that the loader maps the container's full mip chain instead.
+// Pass the asset path as the only argument.
+
+const uint32_t num_channels = 4;
+const char* copy_path = "asset_loader_check.png";
+const char* container_path = "asset_loader_check.tex";
+
+static bool Check(bool condition, const char* message)
+{
+    if(!condition)
+    {
+        printf("FAILED: %s\n", message);
+    }
+    return condition;
+}
+
+static bool CopyFile(const char* source_path, const char* destination_path)
+{
+    FILE* source = fopen(source_path, "rb");
+    if(source == NULL)
+    {
+        return false;
+    }
+    std::vector<char> data;
+    char buffer[4096];
+    size_t size;
+    while((size = fread(buffer, 1, sizeof(buffer), source)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + size);
+    }
+    fclose(source);
+
+    FILE* destination = fopen(destination_path, "wb");
+    if(destination == NULL)
+    {
+        return false;
+    }
+    bool written = data.empty() || fwrite(&data[0], 1, data.size(), destination) == data.size();
+    return fclose(destination) == 0 && written;
+}
+
+static bool LoadAndWait(AssetLoader& asset_loader, const char* path, uint32_t& image_id)
+{
+    image_id = asset_loader.LoadImage(path, num_channels);
+    // With one worker the first poll runs the decode
+    return asset_loader.IsImageReady(image_id);
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        printf("usage: asset_loader_check <image>\n");
+        return 1;
+    }
+
+    // The copy has no container next to it, so the loader must decode it
+    remove(container_path);
+    if(!CopyFile(argv[1], copy_path))
+    {
+        printf("Could not copy %s\n", argv[1]);
+        return 1;
+    }
+
+    stbi_set_flip_vertically_on_load(true);
+    int32_t width;
+    int32_t height;
+    int32_t file_channels;
+    unsigned char* expected_pixels = stbi_load(copy_path, &width, &height, &file_channels, num_channels);
+    if(expected_pixels == NULL)
+    {
+        printf("Could not decode %s\n", argv[1]);
+        return 1;
+    }
+    size_t image_size = (size_t)width * height * num_channels;
+
+    bool passed = true;
+    JobSystem job_system(1);
+    {
+        AssetLoader asset_loader(job_system);
+        uint32_t image_id;
+        passed &= Check(LoadAndWait(asset_loader, copy_path, image_id), "decoded image is ready");
+        passed &= Check(asset_loader.GetImageNumMips(image_id) == 1, "decoded image has one level");
+        ImageMip mip = asset_loader.GetImageMip(image_id, 0);
+        passed &= Check(mip.width == width && mip.height == height, "decoded size");
+        passed &= Check(mip.pixels != NULL && memcmp(mip.pixels, expected_pixels, image_size) == 0, "decoded pixels");
+        asset_loader.FreeImage(image_id);
+        passed &= Check(asset_loader.GetImagePixels(image_id) == NULL, "FreeImage releases the pixels");
+
+        uint32_t missing_id;
+        passed &= Check(LoadAndWait(asset_loader, "asset_loader_check_missing.png", missing_id), "failed decode is ready");
+        passed &= Check(asset_loader.GetImagePixels(missing_id) == NULL, "failed decode has no pixels");
+    }
+
+    std::vector<unsigned char> container;
+    WriteTextureContainer(expected_pixels, width, height, num_channels, container);
+    FILE* container_file = fopen(container_path, "wb");
+    passed &= Check(container_file != NULL && fwrite(&container[0], 1, container.size(), container_file) == container.size(),
+                    "container written");
+    if(container_file != NULL)
+    {
+        fclose(container_file);
+    }
+
+    {
+        AssetLoader asset_loader(job_system);
+        uint32_t image_id;
+        passed &= Check(LoadAndWait(asset_loader, copy_path, image_id), "container is ready");
+        uint32_t num_mips = asset_loader.GetImageNumMips(image_id);
+        passed &= Check(num_mips > 1, "container has the mip chain");
+        ImageMip mip = asset_loader.GetImageMip(image_id, 0);
+        passed &= Check(mip.width == width && mip.height == height, "container size");
+        passed &= Check(memcmp(mip.pixels, expected_pixels, image_size) == 0, "container level 0 matches the decode");
+        for(uint32_t level = 1; level < num_mips; level++)
+        {
+            ImageMip previous_mip = asset_loader.GetImageMip(image_id, level - 1);
+            mip = asset_loader.GetImageMip(image_id, level);
+            passed &= Check(mip.width == (previous_mip.width > 1 ? previous_mip.width / 2 : 1) &&
+                            mip.height == (previous_mip.height > 1 ? previous_mip.height / 2 : 1), "mips halve");
+        }
+        mip = asset_loader.GetImageMip(image_id, num_mips - 1);
+        passed &= Check(mip.width == 1 && mip.height == 1, "chain ends at 1x1");
+    }
+
+    stbi_image_free(expected_pixels);
+    remove(copy_path);
+    remove(container_path);
+
+    printf(passed ? "asset_loader_check passed\n" : "asset_loader_check failed\n");
+    return passed ? 0 : 1;
+}
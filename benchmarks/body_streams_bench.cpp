@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "BodyStreams.hpp"
+#include "RigidBody.hpp"
+#include "Transform.hpp"
+
+// Times the batched integration against the per-entity loop it replaced.
+// PhysicsSystem copies bodies into the streams and back out every step, so
+// the gather and scatter are timed along with the integration itself.
+
+const uint32_t num_steps = 100;
+const float delta_time = 1.0f / 60.0f;
+
+static uint32_t random_state = 12345;
+
+static float RandomFloat()
+{
+    random_state = random_state * 1664525 + 1013904223;
+    return (random_state >> 8) / 16777216.0f - 0.5f;
+}
+
+static double GetNanoseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void RunBenchmark(uint32_t num_bodies)
+{
+    std::vector<Transform> initial_transforms(num_bodies);
+    std::vector<RigidBody> initial_rigid_bodies(num_bodies);
+    memset(&initial_transforms[0], 0, num_bodies * sizeof(Transform));
+    memset(&initial_rigid_bodies[0], 0, num_bodies * sizeof(RigidBody));
+    for(uint32_t i = 0; i < num_bodies; i++)
+    {
+        for(uint32_t j = 0; j < 3; j++)
+        {
+            initial_transforms[i].position[j] = RandomFloat() * 100.0f;
+            initial_rigid_bodies[i].velocity[j] = RandomFloat();
+            initial_rigid_bodies[i].acceleration[j] = RandomFloat() * 0.01f;
+        }
+    }
+
+    // Per entity, as PhysicsSystem did before the streams
+    std::vector<Transform> transforms = initial_transforms;
+    std::vector<RigidBody> rigid_bodies = initial_rigid_bodies;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint32_t step = 0; step < num_steps; step++)
+    {
+        for(uint32_t i = 0; i < num_bodies; i++)
+        {
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                rigid_bodies[i].velocity[j] += rigid_bodies[i].acceleration[j];
+                transforms[i].position[j] += rigid_bodies[i].velocity[j] * delta_time;
+            }
+        }
+    }
+    double per_entity = GetNanoseconds(start);
+
+    std::vector<Transform> stream_transforms = initial_transforms;
+    std::vector<RigidBody> stream_rigid_bodies = initial_rigid_bodies;
+    BodyStreams body_streams;
+    double gather = 0;
+    double integrate = 0;
+    double scatter = 0;
+    for(uint32_t step = 0; step < num_steps; step++)
+    {
+        start = std::chrono::steady_clock::now();
+        body_streams.Clear();
+        for(uint32_t i = 0; i < num_bodies; i++)
+        {
+            body_streams.AddBody(i, stream_transforms[i].position, stream_rigid_bodies[i].velocity,
+                                 stream_rigid_bodies[i].acceleration);
+        }
+        gather += GetNanoseconds(start);
+
+        start = std::chrono::steady_clock::now();
+        body_streams.Integrate(delta_time);
+        integrate += GetNanoseconds(start);
+
+        start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < num_bodies; i++)
+        {
+            uint32_t entity_id = body_streams.GetEntityId(i);
+            body_streams.GetPosition(i, stream_transforms[entity_id].position);
+            body_streams.GetVelocity(i, stream_rigid_bodies[entity_id].velocity);
+        }
+        scatter += GetNanoseconds(start);
+    }
+
+    bool identical = memcmp(&transforms[0], &stream_transforms[0], num_bodies * sizeof(Transform)) == 0 &&
+                     memcmp(&rigid_bodies[0], &stream_rigid_bodies[0], num_bodies * sizeof(RigidBody)) == 0;
+
+    double scale = 1.0 / ((double)num_steps * num_bodies);
+    printf("%7u bodies  per entity %5.2f ns  streams %5.2f ns (gather %5.2f  integrate %5.2f  scatter %5.2f) per body%s\n",
+           num_bodies, per_entity * scale, (gather + integrate + scatter) * scale,
+           gather * scale, integrate * scale, scatter * scale, identical ? "" : "  MISMATCH");
+}
+
+int main()
+{
+    printf("Integration path: %s\n", BodyStreams::GetIntegrationPath());
+    RunBenchmark(1000);
+    RunBenchmark(10000);
+    RunBenchmark(100000);
+    return 0;
+}
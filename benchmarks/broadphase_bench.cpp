@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "SpatialHash.hpp"
+
+// Fills the broadphase with unit boxes scattered over a plane that grows
+// with the body count, so every run sees about the same density, then times
+// a rebuild and one query per body. The all-pairs loop the broadphase
+// replaced is timed alongside it where it finishes in reasonable time.
+
+const float cell_size = 2.0f;
+const uint32_t num_runs = 5;
+const uint32_t max_all_pairs_bodies = 10000;
+
+static uint32_t random_state = 12345;
+
+static float RandomFloat()
+{
+    random_state = random_state * 1664525 + 1013904223;
+    return (random_state >> 8) / 16777216.0f;
+}
+
+static double GetMilliseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool Overlaps(const float* a, const float* b)
+{
+    return a[0] <= b[3] && a[3] >= b[0] &&
+           a[1] <= b[4] && a[4] >= b[1] &&
+           a[2] <= b[5] && a[5] >= b[2];
+}
+
+static void RunBenchmark(uint32_t num_bodies)
+{
+    float side = 0;
+    while(side * side < num_bodies * 8.0f)
+    {
+        side += 1.0f;
+    }
+
+    std::vector<float> bounds(num_bodies * 6);
+    for(uint32_t i = 0; i < num_bodies; i++)
+    {
+        float* box = &bounds[i * 6];
+        box[0] = RandomFloat() * side;
+        box[1] = RandomFloat() * side;
+        box[2] = 0;
+        box[3] = box[0] + 1.0f;
+        box[4] = box[1] + 1.0f;
+        box[5] = 1.0f;
+    }
+
+    SpatialHash broadphase(num_bodies, cell_size);
+    double best_build = 0;
+    double best_query = 0;
+    uint64_t num_candidates = 0;
+    for(uint32_t run = 0; run < num_runs; run++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        broadphase.Clear();
+        for(uint32_t i = 0; i < num_bodies; i++)
+        {
+            broadphase.Insert(i, &bounds[i * 6], &bounds[i * 6 + 3]);
+        }
+        broadphase.Build();
+        double build = GetMilliseconds(start);
+
+        start = std::chrono::steady_clock::now();
+        num_candidates = 0;
+        for(uint32_t i = 0; i < num_bodies; i++)
+        {
+            num_candidates += broadphase.Query(&bounds[i * 6], &bounds[i * 6 + 3]);
+        }
+        double query = GetMilliseconds(start);
+
+        if(run == 0 || build < best_build)
+        {
+            best_build = build;
+        }
+        if(run == 0 || query < best_query)
+        {
+            best_query = query;
+        }
+    }
+
+    printf("%7u bodies  build %8.3f ms  query %8.3f ms  %6.1f ns/query  %5.2f candidates/query",
+           num_bodies, best_build, best_query, best_query * 1000000.0 / num_bodies,
+           (double)num_candidates / num_bodies);
+
+    if(num_bodies <= max_all_pairs_bodies)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint64_t num_overlaps = 0;
+        for(uint32_t i = 0; i < num_bodies; i++)
+        {
+            for(uint32_t j = 0; j < num_bodies; j++)
+            {
+                num_overlaps += Overlaps(&bounds[i * 6], &bounds[j * 6]);
+            }
+        }
+        double all_pairs = GetMilliseconds(start);
+        printf("  all pairs %9.3f ms", all_pairs);
+        if(num_overlaps != num_candidates)
+        {
+            printf("  MISMATCH %llu", (unsigned long long)num_overlaps);
+        }
+    }
+    printf("\n");
+}
+
+int main()
+{
+    RunBenchmark(1000);
+    RunBenchmark(10000);
+    RunBenchmark(100000);
+    return 0;
+}
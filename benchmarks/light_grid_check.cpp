@@ -0,0 +1,158 @@
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "LightGrid.hpp"
+
+// Bins a few lights and compares every cell's light list against a brute
+// force sphere against box test of all lights. A sphere that only grazes a
+// cell's face may be listed or not, since no fragment inside the cell is
+// lit. Also covers cells growing to stay under max_cells, point lookups,
+// and lights whose bounds are not finite or too far apart for the grid.
+
+static bool Check(bool condition, const char* message)
+{
+    if(!condition)
+    {
+        printf("FAILED: %s\n", message);
+    }
+    return condition;
+}
+
+enum CellContact
+{
+    CELL_MISSED,
+    CELL_GRAZED,
+    CELL_REACHED
+};
+
+static CellContact GetCellContact(const GridLight& light, const float* cell_min, float cell_size)
+{
+    float distance_squared = 0;
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        float closest = fmaxf(cell_min[i], fminf(light.position[i], cell_min[i] + cell_size));
+        distance_squared += (light.position[i] - closest) * (light.position[i] - closest);
+    }
+    float tolerance = light.radius * light.radius * 0.0001f;
+    if(distance_squared < light.radius * light.radius - tolerance)
+    {
+        return CELL_REACHED;
+    }
+    return distance_squared > light.radius * light.radius + tolerance ? CELL_MISSED : CELL_GRAZED;
+}
+
+static bool CheckAgainstBruteForce(LightGrid& light_grid)
+{
+    bool passed = true;
+    const int32_t* dimensions = light_grid.GetDimensions();
+    const float* origin = light_grid.GetOrigin();
+    float cell_size = light_grid.GetCellSize();
+    const GridLight* lights = light_grid.GetLights();
+    const LightCellRange* ranges = light_grid.GetCellRanges();
+    const uint32_t* indices = light_grid.GetLightIndices();
+
+    passed &= Check(light_grid.GetNumCells() == (uint32_t)(dimensions[0] * dimensions[1] * dimensions[2]), "cell count");
+    for(int32_t z = 0; z < dimensions[2]; z++)
+    {
+        for(int32_t y = 0; y < dimensions[1]; y++)
+        {
+            for(int32_t x = 0; x < dimensions[0]; x++)
+            {
+                float cell_min[3] = { origin[0] + x * cell_size, origin[1] + y * cell_size, origin[2] + z * cell_size };
+                const LightCellRange& range = ranges[(z * dimensions[1] + y) * dimensions[0] + x];
+
+                std::vector<bool> listed(light_grid.GetNumLights(), false);
+                for(uint32_t i = 0; i < range.num_lights; i++)
+                {
+                    uint32_t light_index = indices[range.first_index + i];
+                    passed &= Check(light_index < light_grid.GetNumLights() && !listed[light_index],
+                                    "cell lists each light once");
+                    if(light_index < light_grid.GetNumLights())
+                    {
+                        listed[light_index] = true;
+                    }
+                }
+                for(uint32_t i = 0; i < light_grid.GetNumLights(); i++)
+                {
+                    CellContact contact = GetCellContact(lights[i], cell_min, cell_size);
+                    passed &= Check(contact == CELL_GRAZED || listed[i] == (contact == CELL_REACHED),
+                                    "cell lights match brute force");
+                }
+
+                vec3 center = { cell_min[0] + cell_size / 2, cell_min[1] + cell_size / 2, cell_min[2] + cell_size / 2 };
+                LightCellRange lookup = light_grid.GetCellRange(center);
+                passed &= Check(lookup.first_index == range.first_index && lookup.num_lights == range.num_lights,
+                                "point lookup finds its cell");
+            }
+        }
+    }
+    return passed;
+}
+
+int main()
+{
+    bool passed = true;
+    vec3 color = { 1, 1, 1 };
+
+    LightGrid light_grid(2.0f, 4096);
+    vec3 positions[] = { { 0, 0, 0 }, { 5, 1, 0 }, { 5.5f, 1, 0.5f }, { -3, 7, 2 }, { 12, -4, 1 } };
+    float radii[] = { 3, 1.5f, 4, 2.5f, 0.5f };
+    for(uint32_t i = 0; i < 5; i++)
+    {
+        light_grid.AddLight(positions[i], radii[i], color);
+    }
+    light_grid.Build();
+    passed &= Check(light_grid.GetCellSize() == 2.0f, "cells keep their base size when they fit");
+    passed &= CheckAgainstBruteForce(light_grid);
+
+    vec3 outside = { 100, 100, 100 };
+    passed &= Check(light_grid.GetCellRange(outside).num_lights == 0, "no lights outside the grid");
+
+    // Too many cells at the base size, so they double until they fit
+    LightGrid coarse_grid(0.5f, 64);
+    for(uint32_t i = 0; i < 5; i++)
+    {
+        coarse_grid.AddLight(positions[i], radii[i], color);
+    }
+    coarse_grid.Build();
+    passed &= Check(coarse_grid.GetCellSize() > 0.5f && coarse_grid.GetNumCells() <= 64, "cells grow to fit max_cells");
+    passed &= CheckAgainstBruteForce(coarse_grid);
+
+    // A cell size that doubling can't grow falls back to one cell
+    LightGrid stuck_grid(0.0f, 64);
+    for(uint32_t i = 0; i < 5; i++)
+    {
+        stuck_grid.AddLight(positions[i], radii[i], color);
+    }
+    stuck_grid.Build();
+    passed &= Check(stuck_grid.GetNumCells() == 1 && stuck_grid.GetNumLightIndices() == 5, "one cell when cells can't grow");
+    passed &= CheckAgainstBruteForce(stuck_grid);
+
+    // Lights that can't be bounded are dropped rather than binned
+    vec3 infinite = { INFINITY, 0, 0 };
+    vec3 not_a_number = { NAN, 0, 0 };
+    vec3 origin = { 0, 0, 0 };
+    LightGrid invalid_grid(2.0f, 4096);
+    invalid_grid.AddLight(infinite, 1, color);
+    invalid_grid.AddLight(not_a_number, 1, color);
+    invalid_grid.AddLight(origin, NAN, color);
+    invalid_grid.AddLight(origin, 1, color);
+    invalid_grid.Build();
+    passed &= Check(invalid_grid.GetNumLights() == 1, "lights with non-finite bounds are ignored");
+    passed &= CheckAgainstBruteForce(invalid_grid);
+
+    // Finite bounds whose extent overflows a float
+    vec3 far_left = { -FLT_MAX / 2, 0, 0 };
+    vec3 far_right = { FLT_MAX / 2, 0, 0 };
+    LightGrid far_grid(2.0f, 4096);
+    far_grid.AddLight(far_left, FLT_MAX / 4, color);
+    far_grid.AddLight(far_right, FLT_MAX / 4, color);
+    far_grid.Build();
+    passed &= Check(far_grid.GetNumCells() >= 1 && far_grid.GetNumCells() <= 4096, "far apart lights stay under max_cells");
+    passed &= Check(far_grid.GetCellRange(far_right).num_lights >= 1, "far apart lights are still found");
+
+    printf(passed ? "light_grid_check passed\n" : "light_grid_check failed\n");
+    return passed ? 0 : 1;
+}
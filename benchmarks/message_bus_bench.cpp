@@ -0,0 +1,182 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MessageBus.hpp"
+#include "System.hpp"
+
+// N producer threads each post M messages while the main thread keeps
+// calling Update, as the game does with systems posting from job threads.
+// The consumer yields between updates so it can't starve the producers when
+// there are fewer cores than threads.
+// The lock-free ring runs with BLOCK so nothing is lost. The mutex queue
+// the ring replaced is reproduced below; it dropped messages when full, so
+// here its producers retry instead and both deliver every message.
+
+const uint32_t max_num_messages = 1024;
+const uint32_t num_messages_per_producer = 1000000;
+
+class CountingSystem : public System
+{
+    public:
+    CountingSystem(MessageBus& message_bus) : System(message_bus, 0), m_num_messages(0)
+    {
+        Subscribe(KEYPRESS);
+    }
+
+    void HandleMessage(Message message)
+    {
+        m_num_messages += message.message_data;
+    }
+
+    void HandleEntity(uint32_t /*entity_id*/, float /*delta_time*/)
+    {
+
+    }
+
+    uint64_t m_num_messages;
+};
+
+class MutexQueue
+{
+    public:
+    MutexQueue(uint32_t max_num_messages) :
+        m_max_num_messages(max_num_messages),
+        m_num_messages(0),
+        m_message_queue_index(0),
+        m_message_queue(new Message[max_num_messages]),
+        m_num_delivered(0)
+    {
+
+    }
+
+    ~MutexQueue()
+    {
+        delete[] m_message_queue;
+    }
+
+    bool PostMessage(Message message)
+    {
+        std::lock_guard<std::mutex> lock(m_post_mutex);
+        if(m_num_messages < m_max_num_messages)
+        {
+            m_message_queue[m_message_queue_index++] = message;
+            if(m_message_queue_index >= m_max_num_messages) m_message_queue_index = 0;
+            m_num_messages++;
+            return true;
+        }
+        return false;
+    }
+
+    void Update()
+    {
+        std::lock_guard<std::mutex> lock(m_post_mutex);
+        uint32_t message_queue_index = (m_message_queue_index + m_max_num_messages - m_num_messages) % m_max_num_messages;
+        for(uint32_t i = 0; i < m_num_messages; i++)
+        {
+            m_num_delivered += m_message_queue[message_queue_index].message_data;
+            message_queue_index++;
+            if(message_queue_index >= m_max_num_messages) message_queue_index = 0;
+        }
+        m_num_messages = 0;
+    }
+
+    const uint32_t m_max_num_messages;
+    uint32_t m_num_messages;
+    uint32_t m_message_queue_index;
+    Message* m_message_queue;
+    std::mutex m_post_mutex;
+    uint64_t m_num_delivered;
+};
+
+static Message GetMessage()
+{
+    Message message;
+    message.message_type = KEYPRESS;
+    message.message_data = 1;
+    return message;
+}
+
+static void PrintResult(const char* name, uint32_t num_producers, std::chrono::steady_clock::time_point start, uint64_t num_delivered)
+{
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t num_posted = (uint64_t)num_producers * num_messages_per_producer;
+    printf("%-12s %2u producers  %8.2f M messages/s%s\n", name, num_producers, num_posted / seconds / 1000000.0,
+           num_delivered == num_posted ? "" : "  LOST MESSAGES");
+}
+
+static void RunRing(uint32_t num_producers)
+{
+    MessageBus message_bus(max_num_messages, 1, MESSAGE_OVERFLOW_BLOCK);
+    CountingSystem counting_system(message_bus);
+    uint64_t num_posted = (uint64_t)num_producers * num_messages_per_producer;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for(uint32_t i = 0; i < num_producers; i++)
+    {
+        producers.push_back(std::thread([&message_bus]()
+        {
+            for(uint32_t j = 0; j < num_messages_per_producer; j++)
+            {
+                message_bus.PostMessage(GetMessage());
+            }
+        }));
+    }
+    while(counting_system.m_num_messages < num_posted)
+    {
+        message_bus.Update();
+        std::this_thread::yield();
+    }
+    for(uint32_t i = 0; i < num_producers; i++)
+    {
+        producers[i].join();
+    }
+    PrintResult("MPSC ring", num_producers, start, counting_system.m_num_messages);
+}
+
+static void RunMutexQueue(uint32_t num_producers)
+{
+    MutexQueue message_queue(max_num_messages);
+    uint64_t num_posted = (uint64_t)num_producers * num_messages_per_producer;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for(uint32_t i = 0; i < num_producers; i++)
+    {
+        producers.push_back(std::thread([&message_queue]()
+        {
+            for(uint32_t j = 0; j < num_messages_per_producer; j++)
+            {
+                while(!message_queue.PostMessage(GetMessage()))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    while(message_queue.m_num_delivered < num_posted)
+    {
+        message_queue.Update();
+        std::this_thread::yield();
+    }
+    for(uint32_t i = 0; i < num_producers; i++)
+    {
+        producers[i].join();
+    }
+    PrintResult("mutex queue", num_producers, start, message_queue.m_num_delivered);
+}
+
+int main()
+{
+    uint32_t num_producers[] = { 1, 4, 16 };
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        RunRing(num_producers[i]);
+        RunMutexQueue(num_producers[i]);
+    }
+    return 0;
+}
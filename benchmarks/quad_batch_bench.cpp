@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdio>
+
+#include "QuadBatch.hpp"
+
+// Times a frame's worth of AddQuad calls and the Build() that sorts and
+// packs them, with quads spread over a few programs and many textures as
+// in a level.
+
+const uint32_t num_runs = 5;
+const uint32_t num_programs = 3;
+const uint32_t num_textures = 16;
+
+static uint32_t random_state = 12345;
+
+static uint32_t RandomUint()
+{
+    random_state = random_state * 1664525 + 1013904223;
+    return random_state >> 8;
+}
+
+static double GetMilliseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void RunBenchmark(uint32_t num_quads)
+{
+    QuadBatch quad_batch;
+    double best_add = 0;
+    double best_build = 0;
+    for(uint32_t run = 0; run < num_runs; run++)
+    {
+        random_state = 12345;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        quad_batch.Clear();
+        for(uint32_t i = 0; i < num_quads; i++)
+        {
+            mat4x4 model_matrix;
+            mat4x4_translate(model_matrix, (float)(i % 100), (float)(i / 100), 0);
+            quad_batch.AddQuad(RandomUint() % num_programs, RandomUint() % num_textures, model_matrix,
+                               0.5f, 0.5f, 0, 0, 1, 1, true);
+        }
+        double add = GetMilliseconds(start);
+
+        start = std::chrono::steady_clock::now();
+        quad_batch.Build();
+        double build = GetMilliseconds(start);
+
+        if(run == 0 || add < best_add)
+        {
+            best_add = add;
+        }
+        if(run == 0 || build < best_build)
+        {
+            best_build = build;
+        }
+    }
+
+    printf("%7u quads  add %8.3f ms  build %8.3f ms  %6.1f ns/quad  %u ranges\n",
+           num_quads, best_add, best_build, (best_add + best_build) * 1000000.0 / num_quads, quad_batch.GetNumRanges());
+}
+
+int main()
+{
+    RunBenchmark(1000);
+    RunBenchmark(10000);
+    RunBenchmark(100000);
+    return 0;
+}
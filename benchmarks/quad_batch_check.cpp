@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <vector>
+
+#include "QuadBatch.hpp"
+
+// Submits quads with their (program, texture) pairs out of order and checks
+// that Build() groups them into sorted ranges, keeps submission order inside
+// each range and emits four vertices and six indices per quad. Each quad is
+// translated along x by its submission index so the order can be read back.
+
+struct TestQuad
+{
+    uint32_t program_index;
+    uint32_t texture_index;
+};
+
+static bool Check(bool condition, const char* message)
+{
+    if(!condition)
+    {
+        printf("FAILED: %s\n", message);
+    }
+    return condition;
+}
+
+int main()
+{
+    TestQuad quads[] = { { 1, 3 }, { 0, 5 }, { 1, 0 }, { 0, 5 }, { 2, 1 }, { 0, 2 }, { 1, 3 }, { 0, 5 }, { 1, 0 } };
+    uint32_t num_quads = sizeof(quads) / sizeof(quads[0]);
+
+    QuadBatch quad_batch;
+    for(uint32_t i = 0; i < num_quads; i++)
+    {
+        mat4x4 model_matrix;
+        mat4x4_translate(model_matrix, (float)i, 0, 0);
+        quad_batch.AddQuad(quads[i].program_index, quads[i].texture_index, model_matrix, 0.5f, 0.5f, 0, 0, 1, 1, i % 2 == 0);
+    }
+    quad_batch.Build();
+
+    bool passed = true;
+    passed &= Check(quad_batch.GetNumQuads() == num_quads, "quad count");
+    passed &= Check(quad_batch.GetNumRanges() == 5, "range count");
+
+    const BatchVertex* vertices = quad_batch.GetVertices();
+    uint32_t next_quad = 0;
+    for(uint32_t i = 0; i < quad_batch.GetNumRanges(); i++)
+    {
+        const QuadBatchRange& range = quad_batch.GetRange(i);
+        passed &= Check(range.first_quad == next_quad, "ranges are contiguous");
+        passed &= Check(range.num_quads > 0, "ranges are not empty");
+        if(i > 0)
+        {
+            const QuadBatchRange& previous = quad_batch.GetRange(i - 1);
+            passed &= Check(previous.program_index < range.program_index ||
+                            (previous.program_index == range.program_index && previous.texture_index < range.texture_index),
+                            "ranges sorted by program, then texture");
+        }
+
+        float previous_x = -1.0f;
+        for(uint32_t j = range.first_quad; j < range.first_quad + range.num_quads; j++)
+        {
+            // The centre of the quad is its submission index
+            float x = (vertices[j * 4 + 0].x + vertices[j * 4 + 3].x) / 2;
+            uint32_t submitted = (uint32_t)(x + 0.5f);
+            passed &= Check(submitted < num_quads && quads[submitted].program_index == range.program_index &&
+                            quads[submitted].texture_index == range.texture_index, "quad lands in its own range");
+            passed &= Check(x > previous_x, "submission order kept within a range");
+            previous_x = x;
+            for(uint32_t k = 0; k < 4; k++)
+            {
+                passed &= Check(vertices[j * 4 + k].layer == (float)range.texture_index, "layer is the texture index");
+                passed &= Check(vertices[j * 4 + k].use_light == (submitted % 2 == 0 ? 1.0f : 0.0f), "use_light follows the quad");
+            }
+        }
+        next_quad += range.num_quads;
+    }
+    passed &= Check(next_quad == num_quads, "ranges cover every quad");
+
+    std::vector<uint32_t> indices;
+    QuadBatch::BuildIndices(num_quads, indices);
+    passed &= Check(indices.size() == num_quads * 6, "six indices per quad");
+    for(uint32_t i = 0; i < indices.size(); i++)
+    {
+        passed &= Check(indices[i] / 4 == i / 6, "indices stay within their quad");
+    }
+
+    quad_batch.Clear();
+    quad_batch.Build();
+    passed &= Check(quad_batch.GetNumQuads() == 0 && quad_batch.GetNumRanges() == 0 && quad_batch.GetVertices() == NULL,
+                    "Clear empties the batch");
+
+    printf(passed ? "quad_batch_check passed\n" : "quad_batch_check failed\n");
+    return passed ? 0 : 1;
+}
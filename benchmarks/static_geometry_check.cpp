@@ -0,0 +1,107 @@
+#include <cmath>
+#include <cstdio>
+
+#include "StaticGeometry.hpp"
+
+// Bakes a known set of static quads and checks the groups that come out:
+// one per (lighting and xray flags, chunk, texture), in that sort order,
+// with bounds covering their quads. Quads larger than a chunk go to chunk
+// 0 wherever they are, and a quad exactly one chunk wide still gets a
+// chunk of its own.
+
+const float chunk_size = 10.0f;
+
+struct TestQuad
+{
+    uint32_t texture_index;
+    bool use_light;
+    bool xray;
+    float x;
+    float y;
+    float half_extent;
+};
+
+struct ExpectedGroup
+{
+    uint32_t texture_index;
+    bool use_light;
+    bool xray;
+    uint32_t chunk_index;
+    uint32_t num_quads;
+    float min[2];
+    float max[2];
+};
+
+static bool Check(bool condition, const char* message)
+{
+    if(!condition)
+    {
+        printf("FAILED: %s\n", message);
+    }
+    return condition;
+}
+
+int main()
+{
+    TestQuad quads[] = { { 1, true,  false,   1,  1, 1 },   // chunk 1
+                         { 1, true,  false,   2,  3, 1 },   // chunk 1, same group
+                         { 2, true,  false,   3,  3, 1 },   // chunk 1, other texture
+                         { 1, true,  false,  15,  1, 1 },   // chunk 2
+                         { 1, false, false,   1,  1, 1 },   // unlit
+                         { 1, true,  true,    1,  1, 1 },   // xray
+                         { 1, true,  false,  50, 50, 8 },   // larger than a chunk
+                         { 1, true,  false, -40,  0, 8 },   // larger than a chunk, far away
+                         { 1, true,  false,   1,  1, 5 } }; // exactly one chunk wide
+    uint32_t num_quads = sizeof(quads) / sizeof(quads[0]);
+
+    ExpectedGroup expected_groups[] = { { 1, false, false, 1, 1, {   0,  0 }, {  2,  2 } },
+                                        { 1, true,  false, 0, 2, { -48, -8 }, { 58, 58 } },
+                                        { 1, true,  false, 1, 3, {  -4, -4 }, {  6,  6 } },
+                                        { 2, true,  false, 1, 1, {   2,  2 }, {  4,  4 } },
+                                        { 1, true,  false, 2, 1, {  14,  0 }, { 16,  2 } },
+                                        { 1, true,  true,  1, 1, {   0,  0 }, {  2,  2 } } };
+    uint32_t num_expected_groups = sizeof(expected_groups) / sizeof(expected_groups[0]);
+
+    StaticGeometry static_geometry(chunk_size);
+    for(uint32_t i = 0; i < num_quads; i++)
+    {
+        mat4x4 model_matrix;
+        mat4x4_translate(model_matrix, quads[i].x, quads[i].y, 0);
+        static_geometry.AddQuad(quads[i].texture_index, quads[i].use_light, quads[i].xray, model_matrix,
+                                quads[i].half_extent, quads[i].half_extent, 0, 0, 1, 1);
+    }
+    static_geometry.Build();
+
+    bool passed = true;
+    passed &= Check(static_geometry.GetNumQuads() == num_quads, "quad count");
+    passed &= Check(static_geometry.GetNumVertices() == num_quads * 4, "four vertices per quad");
+    passed &= Check(static_geometry.GetNumChunks() == 3, "chunk count, counting the oversized chunk");
+    passed &= Check(static_geometry.GetNumGroups() == num_expected_groups, "group count");
+
+    uint32_t next_quad = 0;
+    for(uint32_t i = 0; i < num_expected_groups && i < static_geometry.GetNumGroups(); i++)
+    {
+        const StaticGeometryGroup& group = static_geometry.GetGroup(i);
+        const ExpectedGroup& expected = expected_groups[i];
+        printf("group %u: texture %u light %d xray %d chunk %u quads %u..%u\n", i, group.texture_index,
+               group.use_light, group.xray, group.chunk_index, group.first_quad, group.first_quad + group.num_quads);
+        passed &= Check(group.texture_index == expected.texture_index && group.use_light == expected.use_light &&
+                        group.xray == expected.xray, "group texture and flags");
+        passed &= Check(group.chunk_index == expected.chunk_index, "group chunk");
+        passed &= Check(group.first_quad == next_quad && group.num_quads == expected.num_quads, "group quad range");
+        for(uint32_t j = 0; j < 2; j++)
+        {
+            passed &= Check(fabsf(group.min[j] - expected.min[j]) < 0.001f && fabsf(group.max[j] - expected.max[j]) < 0.001f,
+                            "group bounds");
+        }
+        next_quad += group.num_quads;
+    }
+
+    static_geometry.Clear();
+    static_geometry.Build();
+    passed &= Check(static_geometry.GetNumQuads() == 0 && static_geometry.GetNumGroups() == 0 &&
+                    static_geometry.GetNumChunks() == 1, "Clear empties the bake");
+
+    printf(passed ? "static_geometry_check passed\n" : "static_geometry_check failed\n");
+    return passed ? 0 : 1;
+}
@@ -14,6 +14,9 @@
 #include "Bounds.hpp"
 #include "Label.hpp"
 #include "AIData.hpp"
+#include "CollisionLayer.hpp"
+#include "ModelMatrix.hpp"
+#include "Light.hpp"
 
 class ComponentManager
 {
@@ -24,9 +27,21 @@ class ComponentManager
     template <typename T>
     void AddComponent(uint32_t entity_id, T component);
 
+    template <typename T>
+    void RemoveComponent(uint32_t entity_id);
+
+    template <typename T>
+    bool HasComponent(uint32_t entity_id);
+
     template <typename T>
     T& GetComponent(uint32_t entity_id);
 
+    template <typename T>
+    ComponentPool<T>& GetComponentPool();
+
+    // For destroyed entities, so a reused slot starts with no components
+    void RemoveAllComponents(uint32_t entity_id);
+
     private:
     ComponentPool<Transform> m_transform_pool;
     ComponentPool<Texture> m_texture_pool;
@@ -40,6 +55,49 @@ class ComponentManager
     ComponentPool<Bounds> m_bounds_pool;
     ComponentPool<Label> m_label_pool;
     ComponentPool<AIData> m_ai_data_pool;
+    ComponentPool<CollisionLayer> m_collision_layer_pool;
+    ComponentPool<ModelMatrix> m_model_matrix_pool;
+    ComponentPool<Light> m_light_pool;
 };
 
-#endif // COMPONENT_MANAGER_HPP
\ No newline at end of file
+template <> ComponentPool<Transform>& ComponentManager::GetComponentPool<Transform>();
+template <> ComponentPool<Texture>& ComponentManager::GetComponentPool<Texture>();
+template <> ComponentPool<RigidBody>& ComponentManager::GetComponentPool<RigidBody>();
+template <> ComponentPool<PlayerInput>& ComponentManager::GetComponentPool<PlayerInput>();
+template <> ComponentPool<BoundingBox>& ComponentManager::GetComponentPool<BoundingBox>();
+template <> ComponentPool<Quad>& ComponentManager::GetComponentPool<Quad>();
+template <> ComponentPool<Animation>& ComponentManager::GetComponentPool<Animation>();
+template <> ComponentPool<LabelTexture>& ComponentManager::GetComponentPool<LabelTexture>();
+template <> ComponentPool<Timer>& ComponentManager::GetComponentPool<Timer>();
+template <> ComponentPool<Bounds>& ComponentManager::GetComponentPool<Bounds>();
+template <> ComponentPool<Label>& ComponentManager::GetComponentPool<Label>();
+template <> ComponentPool<AIData>& ComponentManager::GetComponentPool<AIData>();
+template <> ComponentPool<CollisionLayer>& ComponentManager::GetComponentPool<CollisionLayer>();
+template <> ComponentPool<ModelMatrix>& ComponentManager::GetComponentPool<ModelMatrix>();
+template <> ComponentPool<Light>& ComponentManager::GetComponentPool<Light>();
+
+template <typename T>
+void ComponentManager::AddComponent(uint32_t entity_id, T component)
+{
+    GetComponentPool<T>().AddComponent(entity_id, component);
+}
+
+template <typename T>
+void ComponentManager::RemoveComponent(uint32_t entity_id)
+{
+    GetComponentPool<T>().RemoveComponent(entity_id);
+}
+
+template <typename T>
+bool ComponentManager::HasComponent(uint32_t entity_id)
+{
+    return GetComponentPool<T>().HasComponent(entity_id);
+}
+
+template <typename T>
+T& ComponentManager::GetComponent(uint32_t entity_id)
+{
+    return GetComponentPool<T>().GetComponent(entity_id);
+}
+
+#endif // COMPONENT_MANAGER_HPP
@@ -2,8 +2,20 @@
 #define COMPONENT_POOL_HPP
 
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <vector>
 
+const uint32_t invalid_component_index = 0xFFFFFFFF;
+const uint32_t component_chunk_size = 256; // power of two so indexing is a shift and mask
+
+// Sparse set of components. m_sparse maps an entity id to its slot in the
+// packed component chunks and m_entity_ids, and m_presence keeps one bit
+// per entity so HasComponent never touches the component data. Dense storage
+// only grows to the number of entities that actually own a component, one
+// fixed size chunk at a time, so growing never moves existing components.
+// Removing one still moves the last component into its slot.
 template <typename T>
 class ComponentPool
 {
@@ -12,38 +24,179 @@ class ComponentPool
     ~ComponentPool();
 
     void AddComponent(uint32_t entity_id, T component);
+    void RemoveComponent(uint32_t entity_id);
+    bool HasComponent(uint32_t entity_id);
     T& GetComponent(uint32_t entity_id);
 
+    // Dense iteration over live components only
+    uint32_t GetNumComponents();
+    uint32_t GetEntityId(uint32_t index);
+    T& GetComponentAt(uint32_t index);
+
     private:
-    const uint32_t m_num_components;
-    T* m_component_data;
-    
+    void AddChunk();
+    void GrowSparse(uint32_t num_entities);
+
+    uint32_t m_num_entities;
+    uint32_t* m_sparse;
+    uint32_t* m_presence;
+
+    uint32_t m_num_components;
+    uint32_t m_capacity;
+    std::vector<T*> m_component_chunks;
+    uint32_t* m_entity_ids;
 };
 
 
 template <typename T>
-ComponentPool<T>::ComponentPool(uint32_t num_entities) : m_num_components(num_entities),
-                                                         m_component_data(new T[num_entities])
+ComponentPool<T>::ComponentPool(uint32_t num_entities) : m_num_entities(num_entities),
+                                                         m_sparse(new uint32_t[num_entities]),
+                                                         m_presence(new uint32_t[(num_entities + 31) / 32]),
+                                                         m_num_components(0),
+                                                         m_capacity(0),
+                                                         m_entity_ids(NULL)
 {
-    memset(m_component_data, 0, num_entities * sizeof(T));
+    memset(m_sparse, 0xFF, num_entities * sizeof(uint32_t));
+    memset(m_presence, 0, ((num_entities + 31) / 32) * sizeof(uint32_t));
 }
 
 template <typename T>
 ComponentPool<T>::~ComponentPool()
 {
-    delete[] m_component_data;
+    delete[] m_sparse;
+    delete[] m_presence;
+    for(uint32_t i = 0; i < m_component_chunks.size(); i++)
+    {
+        delete[] m_component_chunks[i];
+    }
+    delete[] m_entity_ids;
+}
+
+template <typename T>
+void ComponentPool<T>::AddChunk()
+{
+    T* component_chunk = new T[component_chunk_size];
+    memset(component_chunk, 0, component_chunk_size * sizeof(T));
+    m_component_chunks.push_back(component_chunk);
+
+    // Nothing holds on to entity ids, so this array can simply move
+    uint32_t* entity_ids = new uint32_t[m_capacity + component_chunk_size];
+    if(m_num_components > 0)
+    {
+        memcpy(entity_ids, m_entity_ids, m_num_components * sizeof(uint32_t));
+    }
+    delete[] m_entity_ids;
+    m_entity_ids = entity_ids;
+    m_capacity += component_chunk_size;
+}
+
+// The entity manager can grow after the pool was made, so follow it
+template <typename T>
+void ComponentPool<T>::GrowSparse(uint32_t num_entities)
+{
+    uint32_t num_words = (m_num_entities + 31) / 32;
+    uint32_t new_num_words = (num_entities + 31) / 32;
+
+    uint32_t* sparse = new uint32_t[num_entities];
+    memcpy(sparse, m_sparse, m_num_entities * sizeof(uint32_t));
+    memset(sparse + m_num_entities, 0xFF, (num_entities - m_num_entities) * sizeof(uint32_t));
+    delete[] m_sparse;
+    m_sparse = sparse;
+
+    uint32_t* presence = new uint32_t[new_num_words];
+    memcpy(presence, m_presence, num_words * sizeof(uint32_t));
+    memset(presence + num_words, 0, (new_num_words - num_words) * sizeof(uint32_t));
+    delete[] m_presence;
+    m_presence = presence;
+
+    m_num_entities = num_entities;
 }
 
 template <typename T>
 void ComponentPool<T>::AddComponent(uint32_t entity_id, T component)
 {
-    m_component_data[entity_id] = component;
+    if(HasComponent(entity_id))
+    {
+        GetComponentAt(m_sparse[entity_id]) = component;
+        return;
+    }
+
+    if(entity_id >= m_num_entities)
+    {
+        GrowSparse((entity_id / component_chunk_size + 1) * component_chunk_size);
+    }
+    if(m_num_components == m_capacity)
+    {
+        AddChunk();
+    }
+
+    m_sparse[entity_id] = m_num_components;
+    m_presence[entity_id / 32] |= 1u << (entity_id % 32);
+    GetComponentAt(m_num_components) = component;
+    m_entity_ids[m_num_components] = entity_id;
+    m_num_components++;
+}
+
+template <typename T>
+void ComponentPool<T>::RemoveComponent(uint32_t entity_id)
+{
+    if(!HasComponent(entity_id))
+    {
+        return;
+    }
+
+    // Move the last component into the hole to keep the dense array packed
+    uint32_t index = m_sparse[entity_id];
+    uint32_t last_index = m_num_components - 1;
+    if(index != last_index)
+    {
+        uint32_t last_entity_id = m_entity_ids[last_index];
+        GetComponentAt(index) = GetComponentAt(last_index);
+        m_entity_ids[index] = last_entity_id;
+        m_sparse[last_entity_id] = index;
+    }
+
+    m_sparse[entity_id] = invalid_component_index;
+    m_presence[entity_id / 32] &= ~(1u << (entity_id % 32));
+    m_num_components--;
+}
+
+template <typename T>
+bool ComponentPool<T>::HasComponent(uint32_t entity_id)
+{
+    return entity_id < m_num_entities && ((m_presence[entity_id / 32] >> (entity_id % 32)) & 1u);
 }
 
+// A read never changes the pool, so callers that can't be sure the entity
+// owns the component check HasComponent first. Release builds stop here too
+// rather than read past m_sparse or an unused slot.
 template <typename T>
 T& ComponentPool<T>::GetComponent(uint32_t entity_id)
 {
-    return m_component_data[entity_id];
+    if(!HasComponent(entity_id))
+    {
+        printf("Entity %u has no such component\n", entity_id);
+        abort();
+    }
+    return GetComponentAt(m_sparse[entity_id]);
+}
+
+template <typename T>
+uint32_t ComponentPool<T>::GetNumComponents()
+{
+    return m_num_components;
+}
+
+template <typename T>
+uint32_t ComponentPool<T>::GetEntityId(uint32_t index)
+{
+    return m_entity_ids[index];
+}
+
+template <typename T>
+T& ComponentPool<T>::GetComponentAt(uint32_t index)
+{
+    return m_component_chunks[index / component_chunk_size][index % component_chunk_size];
 }
 
-#endif // COMPONENT_POOL_HPP
\ No newline at end of file
+#endif // COMPONENT_POOL_HPP
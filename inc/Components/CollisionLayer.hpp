@@ -0,0 +1,13 @@
+#ifndef COLLISION_LAYER_HPP
+#define COLLISION_LAYER_HPP
+
+#include <stdint.h>
+
+struct CollisionLayer
+{
+    uint32_t category;      // layers this collider belongs to
+    uint32_t collides_with; // layers that block this collider
+    uint32_t reports_to;    // layers whose contact posts a COLLISION message
+};
+
+#endif // COLLISION_LAYER_HPP
@@ -0,0 +1,12 @@
+#ifndef LIGHT_HPP
+#define LIGHT_HPP
+
+// Point light at the entity's Transform position. Its diffuse falls off
+// linearly to nothing at radius.
+struct Light
+{
+    vec3 color;
+    float radius;
+};
+
+#endif // LIGHT_HPP
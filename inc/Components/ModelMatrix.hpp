@@ -0,0 +1,14 @@
+#ifndef MODEL_MATRIX_HPP
+#define MODEL_MATRIX_HPP
+
+#include "linmath.h"
+
+// Cached translation * rotation built from the entity's Transform. Anything
+// that writes the Transform sets dirty so the matrix is rebuilt on next use.
+struct ModelMatrix
+{
+    mat4x4 matrix;
+    bool dirty;
+};
+
+#endif // MODEL_MATRIX_HPP
@@ -7,6 +7,7 @@ struct RigidBody
 {
     vec3 acceleration;
     vec3 velocity;
+    vec3 previous_position; // position at the start of the last physics step
 };
 
 #endif // RIGID_BODY_HPP
\ No newline at end of file
@@ -10,29 +10,125 @@ enum EntityState
 };
 
 const uint32_t tag_length = 64; // includes null terminator
+const uint32_t max_num_queries = 32;
+const uint32_t invalid_query_id = 0xFFFFFFFF;
+const uint32_t invalid_entity_id = 0xFFFFFFFF;
+const uint32_t invalid_tag_id = 0xFFFFFFFF;
+
+// A handle packs an entity id into the low bits and the generation of its
+// slot into the high bits. Destroying an entity bumps the generation, so
+// handles kept in messages or other systems can be checked for staleness.
+typedef uint32_t EntityHandle;
+const uint32_t entity_index_bits = 20;
+const uint32_t entity_index_mask = (1u << entity_index_bits) - 1;
+const uint32_t entity_generation_mask = 0xFFFFFFFF >> entity_index_bits;
+const uint32_t max_num_entities = entity_index_mask; // the all ones index stays invalid
+const EntityHandle invalid_entity_handle = 0xFFFFFFFF;
+// Slots are added this many at a time once the free list runs dry
+const uint32_t entity_chunk_size = 256;
+
+inline uint32_t GetEntityIndex(EntityHandle handle)
+{
+    return handle & entity_index_mask;
+}
+
+inline uint32_t GetEntityGeneration(EntityHandle handle)
+{
+    return handle >> entity_index_bits;
+}
 
 class EntityManager
 {
     public:
     EntityManager(uint32_t num_entities);
     ~EntityManager();
+
+    // Create reuses the most recently destroyed slot, or takes a new one and
+    // grows the manager by a chunk when there is none. New entities start
+    // INACTIVE with no signature. Growing moves the query entity lists, so
+    // pointers from GetQueryEntities are only good until the next Create.
+    EntityHandle Create();
+    // Clears the entity out of every query and frees its slot. Components
+    // are left to ComponentManager::RemoveAllComponents.
+    void Destroy(EntityHandle handle);
+    bool IsAlive(EntityHandle handle);
+    EntityHandle GetEntityHandle(uint32_t entity_id);
+    uint32_t GetNumAliveEntities();
     
     void SetEntitySignature(uint32_t entity_id, uint32_t signature);
     void SetEntityState(uint32_t entity_id, EntityState state);
-    void SetEntityTag(uint32_t entity_id, char* tag);
+    void SetEntityTag(uint32_t entity_id, const char* tag);
+    // Number of entity slots, alive or not. Ids are always below this.
+    // For an id past it the getters below return no signature, INACTIVE,
+    // the empty tag name and invalid_tag_id.
     uint32_t GetNumEntities();
     uint32_t GetEntitySignature(uint32_t entity_id);
     EntityState GetEntityState(uint32_t entity_id);
-    uint32_t GetEntityId(char* entity_tag);
-    char* GetEntityTag(uint32_t entity_id);
+    const char* GetEntityTag(uint32_t entity_id);
+
+    // Tags are interned into stable ids that systems can resolve once and
+    // cache, so entities only store a tag id and compare tags as integers.
+    // Lookups return the entity most recently given the tag, or
+    // invalid_entity_id if no entity carries it. Untagged entities share
+    // the id of the empty tag, which never resolves to an entity.
+    // Ids from GetTagId stay valid for the life of the manager. A tag only
+    // ever set through SetEntityTag is freed once no entity holds it, so
+    // an id from GetEntityTagId is only good while the entity keeps it.
+    uint32_t GetTagId(const char* tag);
+    uint32_t GetEntityTagId(uint32_t entity_id);
+    uint32_t GetEntityId(const char* entity_tag);
+    uint32_t GetEntityId(uint32_t tag_id);
+
+    // A query tracks every ACTIVE entity sharing at least one bit with its
+    // signature. Membership is updated whenever an entity's signature or
+    // state changes. The entity list is in no particular order: removing an
+    // entity moves the last one into its place.
+    uint32_t RegisterQuery(uint32_t signature);
+    uint32_t GetQuerySize(uint32_t query_id);
+    uint32_t* GetQueryEntities(uint32_t query_id);
 
     private:
-    const uint32_t m_num_entities;
+    void UpdateQueries(uint32_t entity_id);
+    uint32_t InternTag(const char* tag);
+    uint32_t FindTag(const char* tag, uint32_t hash);
+    void InsertTag(uint32_t tag_id);
+    void ReleaseTag(uint32_t tag_id);
+    void LinkTagHolder(uint32_t entity_id);
+    void UnlinkTagHolder(uint32_t entity_id);
+    void GrowTags(uint32_t max_num_tags);
+    void Grow(uint32_t num_entities);
+
+    uint32_t m_num_entities;
     uint32_t* m_entity_signatures;
-    char** m_entity_tags;
     EntityState* m_entity_states;
 
+    uint32_t m_num_used_entities; // slots handed out at least once
+    uint32_t* m_entity_generations;
+    bool* m_entity_alive;
+    uint32_t m_num_free_entities;
+    uint32_t* m_free_entities; // stack of destroyed slots
+
+    uint32_t m_num_queries;
+    uint32_t m_query_signatures[max_num_queries];
+    uint32_t m_query_sizes[max_num_queries];
+    uint32_t* m_query_entities[max_num_queries];
+    uint32_t* m_query_positions[max_num_queries]; // index into the entity list, per entity
+    uint32_t* m_query_membership; // one bit per query for each entity
+
+    uint32_t m_max_num_tags;
+    uint32_t m_num_tags;
+    char* m_tag_names; // one slab, tag_length bytes per tag
+    uint32_t* m_tag_hashes;
+    uint32_t* m_tag_entities; // newest holder, head of the holder list
+    bool* m_tag_pinned; // handed out by GetTagId, so never freed
+    uint32_t m_num_free_tags;
+    uint32_t* m_free_tags; // stack of released tag ids
+    uint32_t m_tag_table_mask;
+    uint32_t* m_tag_table; // open addressing, stores tag id + 1 (0 is empty)
+    uint32_t* m_entity_tag_ids;
+    uint32_t* m_entity_tag_next; // next older holder of the same tag
+    uint32_t* m_entity_tag_previous;
 
 };
 
-#endif // ENTITY_MANAGER_HPP
\ No newline at end of file
+#endif // ENTITY_MANAGER_HPP
@@ -0,0 +1,66 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+typedef void (*JobFunction)(void* data, uint32_t begin, uint32_t end);
+
+// Number of jobs still running in a group. Wait on it to join the group.
+typedef std::atomic<uint32_t> JobCounter;
+
+struct Job
+{
+    JobFunction function;
+    void* data;
+    uint32_t begin;
+    uint32_t end;
+    JobCounter* counter;
+};
+
+// Work stealing thread pool. Every worker owns a deque: it pushes and pops
+// its own jobs at the back, and idle workers steal from the front of the
+// others. The thread that created the job system is worker 0 and only runs
+// jobs while it is waiting on a counter.
+class JobSystem
+{
+    public:
+    JobSystem(uint32_t num_threads);
+    ~JobSystem();
+
+    void Submit(JobFunction function, void* data, uint32_t begin, uint32_t end, JobCounter& counter);
+    // Splits [0, count) into ranges of at most chunk_size and submits each
+    void SubmitRange(JobFunction function, void* data, uint32_t count, uint32_t chunk_size, JobCounter& counter);
+    // Runs queued jobs on the calling thread until the counter reaches zero
+    void Wait(JobCounter& counter);
+
+    uint32_t GetNumThreads();
+
+    private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void WorkerLoop(uint32_t worker_index);
+    bool PopJob(uint32_t worker_index, Job& job);
+    bool StealJob(uint32_t worker_index, Job& job);
+    void RunJob(Job& job);
+    uint32_t GetWorkerIndex();
+
+    const uint32_t m_num_threads;
+    WorkerQueue* m_queues;
+    std::thread* m_threads;
+
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_sleep_condition;
+    std::atomic<uint32_t> m_num_queued_jobs;
+    std::atomic<bool> m_running;
+};
+
+#endif // JOB_SYSTEM_HPP
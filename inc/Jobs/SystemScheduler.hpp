@@ -0,0 +1,47 @@
+#ifndef SYSTEM_SCHEDULER_HPP
+#define SYSTEM_SCHEDULER_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "JobSystem.hpp"
+#include "System.hpp"
+
+// Runs a list of systems on the job system. Systems are grouped into stages
+// in the order they were added: a system goes into the stage after the last
+// earlier system it conflicts with. The systems in a stage run at the same
+// time, and chunkable systems are also split into ranges of entities.
+// Systems that issue GL calls must stay on the main thread and are not added
+// here.
+class SystemScheduler
+{
+    public:
+    SystemScheduler(JobSystem& job_system, uint32_t chunk_size);
+    ~SystemScheduler();
+
+    void AddSystem(System* system);
+    void Update(float delta_time);
+
+    uint32_t GetNumStages();
+
+    private:
+    struct SystemJob
+    {
+        System* system;
+        float delta_time;
+    };
+
+    static void RunSystem(void* data, uint32_t begin, uint32_t end);
+    static void RunSystemRange(void* data, uint32_t begin, uint32_t end);
+    bool Conflicts(System* a, System* b);
+
+    JobSystem& m_job_system;
+    const uint32_t m_chunk_size;
+
+    std::vector<System*> m_systems;
+    std::vector<uint32_t> m_system_stages;
+    std::vector<SystemJob> m_system_jobs;
+    uint32_t m_num_stages;
+};
+
+#endif // SYSTEM_SCHEDULER_HPP
@@ -0,0 +1,35 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Bump allocator that is emptied all at once. Allocate is lock-free until the
+// arena runs out, after which it spills to the heap and grows on Reset.
+class FrameArena
+{
+    public:
+    FrameArena(uint32_t capacity);
+    ~FrameArena();
+
+    // Returns 0 when the arena is full and spilling isn't allowed
+    void* Allocate(uint32_t size, uint32_t alignment, bool allow_spill);
+    // Must not run while other threads allocate
+    void Reset();
+
+    uint32_t GetCapacity();
+    uint32_t GetNumSpilledBytes();
+
+    private:
+    uint32_t m_capacity;
+    char* m_memory;
+    std::atomic<uint32_t> m_offset;
+
+    std::mutex m_spill_mutex;
+    std::vector<char*> m_spilled_blocks;
+    uint32_t m_num_spilled_bytes;
+};
+
+#endif // FRAME_ARENA_HPP
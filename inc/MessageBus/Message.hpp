@@ -11,13 +11,16 @@ enum MessageType
     COLLISION,
     ZOOM,
     XRAY,
-    RESTART
+    RESTART,
+    NUM_MESSAGE_TYPES
 };
 
 struct Message
 {
     MessageType message_type;
     uint32_t message_data;
+    // Lives in the bus's payload arena until the Update that delivers it returns
+    const void* payload = 0;
 };
 
 #endif // MESSAGE_HPP
\ No newline at end of file
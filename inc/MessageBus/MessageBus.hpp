@@ -1,30 +1,103 @@
 #ifndef MESSAGE_BUS_HPP
 #define MESSAGE_BUS_HPP
 
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "System.hpp"
 #include "Message.hpp"
+#include "FrameArena.hpp"
 
 class System;
 
+// What PostMessage does when the ring is full
+enum MessageOverflowPolicy
+{
+    MESSAGE_OVERFLOW_DROP,  // discard the message and count it
+    MESSAGE_OVERFLOW_BLOCK, // wait for Update to make room, or GROW on Update's own thread
+    MESSAGE_OVERFLOW_GROW   // keep it aside and enlarge the ring on the next Update
+};
+
+// Any thread may post without locking. Update is the only consumer and must
+// run on one thread, which is taken to be the constructing thread until the
+// first Update. A GROW resize and the payload arena reset both assume nothing
+// is posting while Update runs, except the handlers it calls.
 class MessageBus
 {
     public:
-    MessageBus(uint32_t max_num_messages, uint32_t max_num_systems);
+    MessageBus(uint32_t max_num_messages, uint32_t max_num_systems, MessageOverflowPolicy overflow_policy = MESSAGE_OVERFLOW_DROP,
+               uint32_t payload_arena_size = 16384);
     ~MessageBus();
-    void RegisterSystem(System* system);
+    // Only subscribers of a message's type have it delivered
+    void Subscribe(System* system, MessageType message_type);
     void Update();
     void PostMessage(Message message);
+    // Copies the payload into this frame's arena, so T must be trivially copyable
+    template<typename T>
+    void PostMessage(MessageType message_type, const T& payload);
+    // Returns 0 if the arena is full and the policy is DROP
+    void* AllocatePayload(uint32_t size, uint32_t alignment);
+
+    uint32_t GetCapacity();
+    uint32_t GetNumDroppedMessages();
 
     private:
-    const uint32_t m_max_num_messages;
-    uint32_t m_num_messages;
-    uint32_t m_message_queue_index;
-    Message* m_message_queue;
+    struct Slot
+    {
+        // Equals the write index when free and write index + 1 once published
+        std::atomic<uint32_t> sequence;
+        Message message;
+    };
+
+    bool TryPush(const Message& message);
+    bool TryPop(Message& message);
+    void Resize(uint32_t capacity);
+
+    const MessageOverflowPolicy m_overflow_policy;
+    uint32_t m_capacity;
+    uint32_t m_mask;
+    Slot* m_slots;
+    // Producers and the consumer touch different cache lines
+    alignas(64) std::atomic<uint32_t> m_tail;
+    alignas(64) uint32_t m_head;
+
+    std::mutex m_overflow_mutex;
+    std::vector<Message> m_overflow_messages;
+    std::vector<Message> m_pending_overflow_messages;
+    std::atomic<uint32_t> m_num_dropped_messages;
+    // Blocking here would wait on ourselves
+    std::atomic<std::thread::id> m_consumer_thread;
+
+    // Payloads go to one arena while Update delivers and then resets the other
+    FrameArena m_payload_arenas[2];
+    std::atomic<uint32_t> m_payload_arena_index;
+
+    void Dispatch(const Message& message);
 
     const uint32_t m_max_num_systems;
-    uint32_t m_num_systems;
-    System** m_systems;
+    uint32_t m_num_subscribers[NUM_MESSAGE_TYPES];
+    System** m_subscribers[NUM_MESSAGE_TYPES];
 
 };
 
-#endif // MESSAGE_BUS_HPP
\ No newline at end of file
+template<typename T>
+void MessageBus::PostMessage(MessageType message_type, const T& payload)
+{
+    void* payload_memory = AllocatePayload(sizeof(T), alignof(T));
+    if(payload_memory == 0)
+    {
+        return;
+    }
+    memcpy(payload_memory, &payload, sizeof(T));
+
+    Message message;
+    message.message_type = message_type;
+    message.message_data = sizeof(T);
+    message.payload = payload_memory;
+    PostMessage(message);
+}
+
+#endif // MESSAGE_BUS_HPP
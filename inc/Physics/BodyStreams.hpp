@@ -0,0 +1,42 @@
+#ifndef BODY_STREAMS_HPP
+#define BODY_STREAMS_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "linmath.h"
+
+// Structure of arrays copy of the bodies integrated together in one step.
+// Each axis is its own stream so the integration loop can work on several
+// bodies per instruction. The streams are not persistent: PhysicsSystem
+// gathers the bodies from their components and scatters the results back
+// every step. The AVX path needs the ENABLE_AVX CMake option, otherwise
+// SSE is used.
+class BodyStreams
+{
+    public:
+    BodyStreams();
+    ~BodyStreams();
+
+    void Clear();
+    void AddBody(uint32_t entity_id, const vec3 position, const vec3 velocity, const vec3 acceleration);
+
+    // velocity += acceleration, then position += velocity * delta_time
+    void Integrate(float delta_time);
+
+    uint32_t GetNumBodies();
+    uint32_t GetEntityId(uint32_t index);
+    void GetPosition(uint32_t index, vec3 position);
+    void GetVelocity(uint32_t index, vec3 velocity);
+
+    // "AVX", "SSE" or "scalar", as BodyStreams.cpp was compiled
+    static const char* GetIntegrationPath();
+
+    private:
+    std::vector<uint32_t> m_entity_ids;
+    std::vector<float> m_position[3];
+    std::vector<float> m_velocity[3];
+    std::vector<float> m_acceleration[3];
+};
+
+#endif // BODY_STREAMS_HPP
@@ -0,0 +1,45 @@
+#ifndef CONTACT_STREAM_HPP
+#define CONTACT_STREAM_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "linmath.h"
+
+// Payload of COLLISION messages. Holds every reported contact from one
+// physics step as parallel arrays; contact i is entry i of each array.
+// Entities are EntityHandles, so check IsAlive before using them.
+struct ContactStreamPayload
+{
+    uint32_t num_contacts;
+    const uint32_t* entity_ids;
+    const uint32_t* other_entity_ids;
+    const float* normals[3];
+    const float* times_of_impact; // fraction of the physics step
+};
+
+// Structure of arrays buffer the physics system fills during a step and
+// then copies into a single message payload.
+class ContactStream
+{
+    public:
+    ContactStream();
+    ~ContactStream();
+
+    void Clear();
+    void AddContact(uint32_t entity_id, uint32_t other_entity_id, const vec3 normal, float time_of_impact);
+
+    uint32_t GetNumContacts();
+    // Bytes WritePayload needs, including the ContactStreamPayload itself
+    uint32_t GetPayloadSize();
+    // memory must be aligned for ContactStreamPayload
+    const ContactStreamPayload* WritePayload(void* memory);
+
+    private:
+    std::vector<uint32_t> m_entity_ids;
+    std::vector<uint32_t> m_other_entity_ids;
+    std::vector<float> m_normals[3];
+    std::vector<float> m_times_of_impact;
+};
+
+#endif // CONTACT_STREAM_HPP
@@ -0,0 +1,50 @@
+#ifndef SPATIAL_HASH_HPP
+#define SPATIAL_HASH_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "linmath.h"
+
+// Uniform grid broadphase. Boxes are inserted into every cell they overlap
+// and the cells are hashed into buckets, so only occupied cells cost memory.
+// Boxes spanning more than max_cells_per_item cells are kept in a separate
+// list that every query tests directly.
+class SpatialHash
+{
+    public:
+    SpatialHash(uint32_t max_num_items, float cell_size);
+    ~SpatialHash();
+
+    void Clear();
+    void Insert(uint32_t item_id, const vec3 min, const vec3 max);
+    void Build();
+
+    // Returns the number of inserted items whose box overlaps the query box
+    uint32_t Query(const vec3 min, const vec3 max);
+    uint32_t* GetCandidates();
+    uint32_t GetMaxNumItems();
+
+    private:
+    bool GetCellRange(const float* min, const float* max, int32_t* cell_min, int32_t* cell_max);
+    uint32_t GetBucket(int32_t x, int32_t y, int32_t z);
+    void AddCandidate(uint32_t item_index, const float* min, const float* max);
+
+    const uint32_t m_max_num_items;
+    const float m_cell_size;
+    const uint32_t m_max_cells_per_item;
+
+    uint32_t m_num_items;
+    uint32_t* m_item_ids;
+    float* m_item_bounds; // min xyz, max xyz per item
+    uint32_t* m_item_stamps;
+    uint32_t m_query_stamp;
+
+    uint32_t m_bucket_mask;
+    uint32_t* m_bucket_starts; // m_bucket_mask + 2 entries
+    std::vector<uint32_t> m_bucket_items;
+    std::vector<uint32_t> m_oversized_items;
+    std::vector<uint32_t> m_candidates;
+};
+
+#endif // SPATIAL_HASH_HPP
@@ -0,0 +1,50 @@
+#ifndef STATIC_BVH_HPP
+#define STATIC_BVH_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "linmath.h"
+
+// Bounding volume hierarchy over boxes that never move. It is built once
+// and is read only afterwards. Nodes are stored depth first, so a node's
+// left child comes right after it and only the right child index is kept.
+class StaticBvh
+{
+    public:
+    StaticBvh();
+    ~StaticBvh();
+
+    void Clear();
+    void Insert(uint32_t item_id, const vec3 min, const vec3 max);
+    void Build();
+
+    // Returns the number of items whose box overlaps the query box. The
+    // results are indices that can be passed to GetItemId/GetItemBounds.
+    uint32_t Query(const vec3 min, const vec3 max);
+    uint32_t* GetResults();
+
+    uint32_t GetNumItems();
+    uint32_t GetItemId(uint32_t index);
+    const float* GetItemBounds(uint32_t index); // min xyz, max xyz
+
+    private:
+    struct Node
+    {
+        float bounds[6];
+        uint32_t right_child;
+        uint32_t first_item;
+        uint32_t num_items; // 0 for interior nodes
+    };
+
+    uint32_t BuildNode(uint32_t first_item, uint32_t num_items);
+
+    std::vector<uint32_t> m_item_ids;
+    std::vector<float> m_item_bounds;
+    std::vector<uint32_t> m_item_order;
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_stack;
+    std::vector<uint32_t> m_results;
+};
+
+#endif // STATIC_BVH_HPP
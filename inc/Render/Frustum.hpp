@@ -0,0 +1,27 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <stdint.h>
+
+#include "linmath.h"
+
+// The six planes of a camera's view volume, taken from its projection *
+// view matrix. Plane normals point inwards, so a point is inside when its
+// distance to every plane is positive. Tests are conservative and only
+// reject volumes that are fully outside one plane.
+class Frustum
+{
+    public:
+    Frustum();
+    ~Frustum();
+
+    void Build(mat4x4 view_projection_matrix);
+
+    bool IntersectsSphere(const vec3 center, float radius);
+    bool IntersectsBox(const vec3 min, const vec3 max);
+
+    private:
+    vec4 m_planes[6];
+};
+
+#endif // FRUSTUM_HPP
@@ -0,0 +1,68 @@
+#ifndef LIGHT_GRID_HPP
+#define LIGHT_GRID_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "linmath.h"
+
+// Light as the shaders read it, two texels per light
+struct GridLight
+{
+    float position[3];
+    float radius;
+    float color[3];
+    float padding;
+};
+
+// Where a cell's lights start in the light index list and how many it has
+struct LightCellRange
+{
+    uint32_t first_index;
+    uint32_t num_lights;
+};
+
+// Bins point lights into a uniform grid of world space clusters around them.
+// Every cell lists the lights whose sphere reaches it, so a fragment only
+// evaluates the lights of its own cell. Cells grow if the lights spread over
+// more than max_cells. Lights without finite bounds are ignored.
+// benchmarks/light_grid_check compares the binning against brute force.
+class LightGrid
+{
+    public:
+    LightGrid(float cell_size, uint32_t max_cells);
+    ~LightGrid();
+
+    void Clear();
+    void AddLight(const vec3 position, float radius, const vec3 color);
+    void Build();
+
+    uint32_t GetNumLights();
+    const GridLight* GetLights();
+    uint32_t GetNumCells();
+    const LightCellRange* GetCellRanges();
+    uint32_t GetNumLightIndices();
+    const uint32_t* GetLightIndices();
+
+    // Cell coordinates of a point are floor((point - origin) / cell size)
+    const float* GetOrigin();
+    float GetCellSize();
+    const int32_t* GetDimensions();
+
+    // The range of the cell holding position, empty outside the grid
+    LightCellRange GetCellRange(const vec3 position);
+
+    private:
+    float m_base_cell_size;
+    uint32_t m_max_cells;
+
+    vec3 m_origin;
+    float m_cell_size;
+    int32_t m_dimensions[3];
+
+    std::vector<GridLight> m_lights;
+    std::vector<LightCellRange> m_cell_ranges;
+    std::vector<uint32_t> m_light_indices;
+};
+
+#endif // LIGHT_GRID_HPP
@@ -0,0 +1,67 @@
+#ifndef QUAD_BATCH_HPP
+#define QUAD_BATCH_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "linmath.h"
+
+struct BatchVertex
+{
+    float x;
+    float y;
+    float z;
+    float u;
+    float v;
+    float use_light;
+    float layer;
+};
+
+// Quads that share a program and texture, drawn with one call
+struct QuadBatchRange
+{
+    uint32_t program_index;
+    uint32_t texture_index;
+    uint32_t first_quad;
+    uint32_t num_quads;
+};
+
+// Collects the quads of a frame and transforms them into world space on the
+// CPU, so all of them can share one vertex buffer. Build() sorts the quads
+// by program and then texture, keeping submission order within each pair,
+// and packs the vertices four per quad. The texture index is also written
+// into each vertex as its texture array layer. RenderSystem does the upload,
+// which lets benchmarks/quad_batch_check run this without a GL context.
+class QuadBatch
+{
+    public:
+    QuadBatch();
+    ~QuadBatch();
+
+    void Clear();
+    void AddQuad(uint32_t program_index, uint32_t texture_index, mat4x4 model_matrix,
+                 float half_width, float half_height, float u1, float v1, float u2, float v2, bool use_light);
+    void Build();
+
+    uint32_t GetNumQuads();
+    uint32_t GetNumRanges();
+    const QuadBatchRange& GetRange(uint32_t index);
+    const BatchVertex* GetVertices();
+
+    // Two triangles per quad over vertices laid out like a triangle strip
+    static void BuildIndices(uint32_t num_quads, std::vector<uint32_t>& indices);
+
+    private:
+    struct QuadKey
+    {
+        uint64_t key;
+        uint32_t quad_index;
+    };
+
+    std::vector<QuadKey> m_keys;
+    std::vector<BatchVertex> m_unsorted_vertices;
+    std::vector<BatchVertex> m_vertices;
+    std::vector<QuadBatchRange> m_ranges;
+};
+
+#endif // QUAD_BATCH_HPP
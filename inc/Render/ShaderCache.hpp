@@ -0,0 +1,63 @@
+#ifndef SHADER_CACHE_HPP
+#define SHADER_CACHE_HPP
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// What the cache did since it was created
+struct ShaderCacheStats
+{
+    uint32_t programs_compiled;
+    uint32_t programs_loaded;
+    uint32_t programs_reused;
+    double milliseconds;
+};
+
+// Builds GL programs from vertex and fragment source. Programs are keyed by
+// a hash of their sources, so asking twice for the same pair returns the
+// same program. Linked programs are written to the cache directory with
+// glGetProgramBinary and loaded from there on the next start. Drivers that
+// report no binary formats, or reject a stored binary, fall back to
+// compiling. Active uniforms and attributes are looked up once per program.
+class ShaderCache
+{
+    public:
+    ShaderCache(const char* cache_directory);
+    ~ShaderCache();
+
+    // Returns 0 if the program failed to build
+    uint32_t GetProgram(const char* vertex_source, const char* fragment_source);
+
+    // -1 when the program has no such active uniform or attribute
+    int32_t GetUniformLocation(uint32_t program, const char* name);
+    int32_t GetAttribLocation(uint32_t program, const char* name);
+
+    const ShaderCacheStats& GetStats();
+
+    private:
+    struct CachedProgram
+    {
+        uint64_t hash;
+        uint32_t program;
+        std::map<std::string, int32_t> uniform_locations;
+        std::map<std::string, int32_t> attrib_locations;
+    };
+
+    uint32_t CompileProgram(const char* vertex_source, const char* fragment_source);
+    uint32_t CompileShader(uint32_t type, const char* source);
+    uint32_t LoadProgramBinary(uint64_t hash);
+    void SaveProgramBinary(uint64_t hash, uint32_t program);
+    void GetBinaryPath(uint64_t hash, std::string& path);
+    void ReflectProgram(CachedProgram& cached_program);
+    CachedProgram* FindProgram(uint32_t program);
+
+    std::string m_cache_directory;
+    bool m_binaries_supported;
+    uint64_t m_driver_hash;
+    std::vector<CachedProgram> m_programs;
+    ShaderCacheStats m_stats;
+};
+
+#endif // SHADER_CACHE_HPP
@@ -0,0 +1,57 @@
+#ifndef STATIC_GEOMETRY_HPP
+#define STATIC_GEOMETRY_HPP
+
+#include <stdint.h>
+#include <map>
+
+#include "linmath.h"
+#include "QuadBatch.hpp"
+
+// Static quads in one chunk that share a texture and lighting mode,
+// contiguous in the bake. Xray quads get their own groups since their
+// program is picked at draw time. Bounds cover every quad in the group.
+struct StaticGeometryGroup
+{
+    uint32_t texture_index;
+    bool use_light;
+    bool xray;
+    uint32_t chunk_index;
+    uint32_t first_quad;
+    uint32_t num_quads;
+    vec3 min;
+    vec3 max;
+};
+
+// Level geometry baked once at load. Quads are transformed into world space
+// and grouped so the whole level can live in one static vertex buffer.
+// Quads are also split into cubic chunks by their center so groups can be
+// culled. Quads larger than a chunk all share chunk 0.
+// benchmarks/static_geometry_check bakes a fixed level to pin the groups.
+class StaticGeometry
+{
+    public:
+    StaticGeometry(float chunk_size);
+    ~StaticGeometry();
+
+    void Clear();
+    void AddQuad(uint32_t texture_index, bool use_light, bool xray, mat4x4 model_matrix,
+                 float half_width, float half_height, float u1, float v1, float u2, float v2);
+    void Build();
+
+    uint32_t GetNumQuads();
+    uint32_t GetNumVertices();
+    uint32_t GetNumChunks();
+    uint32_t GetNumGroups();
+    const StaticGeometryGroup& GetGroup(uint32_t index);
+    const BatchVertex* GetVertices();
+
+    private:
+    // QuadBatch sorts on the program index first, so the group flags and
+    // chunk go there
+    QuadBatch m_quads;
+    float m_chunk_size;
+    std::map<uint64_t, uint32_t> m_chunk_indices;
+    std::vector<StaticGeometryGroup> m_groups;
+};
+
+#endif // STATIC_GEOMETRY_HPP
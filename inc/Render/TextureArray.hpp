@@ -0,0 +1,38 @@
+#ifndef TEXTURE_ARRAY_HPP
+#define TEXTURE_ARRAY_HPP
+
+#include <stdint.h>
+#include <vector>
+
+// Packs RGBA images into equally sized layers for one GL_TEXTURE_2D_ARRAY.
+// Smaller images are tiled across their whole layer, so a layer repeats
+// with the period of its image. Texel coordinates into the original image
+// then only need dividing by the layer size, and GL_REPEAT on the array
+// keeps repeating textures like the road working. RenderSystem uploads the
+// packed pixels itself.
+class TextureArray
+{
+    public:
+    TextureArray(uint32_t layer_width, uint32_t layer_height);
+    ~TextureArray();
+
+    // Returns the layer index
+    uint32_t AddLayer(const unsigned char* pixels, uint32_t width, uint32_t height);
+
+    // Tiles an image across a single layer, for replacing one layer later
+    static void TileImage(const unsigned char* pixels, uint32_t width, uint32_t height,
+                          uint32_t layer_width, uint32_t layer_height, unsigned char* layer);
+
+    uint32_t GetLayerWidth();
+    uint32_t GetLayerHeight();
+    uint32_t GetNumLayers();
+    const unsigned char* GetPixels();
+
+    private:
+    uint32_t m_layer_width;
+    uint32_t m_layer_height;
+    uint32_t m_num_layers;
+    std::vector<unsigned char> m_pixels;
+};
+
+#endif // TEXTURE_ARRAY_HPP
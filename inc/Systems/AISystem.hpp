@@ -3,6 +3,8 @@
 
 #include "System.hpp"
 #include "Signatures.hpp"
+#include "CollisionLayers.hpp"
+#include "ContactStream.hpp"
 
 class AISystem : public System
 {
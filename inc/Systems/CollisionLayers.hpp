@@ -0,0 +1,13 @@
+#ifndef COLLISION_LAYERS_HPP
+#define COLLISION_LAYERS_HPP
+
+#include <stdint.h>
+
+const uint32_t PLAYER_COLLISION_LAYER =    0x00000001;
+const uint32_t WALL_COLLISION_LAYER =      0x00000002;
+const uint32_t SIDE_WALL_COLLISION_LAYER = 0x00000004;
+const uint32_t ENEMY_COLLISION_LAYER =     0x00000008;
+const uint32_t BULLET_COLLISION_LAYER =    0x00000010;
+const uint32_t ALL_COLLISION_LAYERS =      0xFFFFFFFF;
+
+#endif // COLLISION_LAYERS_HPP
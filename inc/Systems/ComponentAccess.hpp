@@ -0,0 +1,27 @@
+#ifndef COMPONENT_ACCESS_HPP
+#define COMPONENT_ACCESS_HPP
+
+#include <stdint.h>
+
+// What a system reads and writes. The scheduler only runs two systems at
+// the same time if neither one writes something the other touches.
+const uint32_t TRANSFORM_ACCESS =       0x00000001;
+const uint32_t TEXTURE_ACCESS =         0x00000002;
+const uint32_t RIGID_BODY_ACCESS =      0x00000004;
+const uint32_t PLAYER_INPUT_ACCESS =    0x00000008;
+const uint32_t BOUNDING_BOX_ACCESS =    0x00000010;
+const uint32_t QUAD_ACCESS =            0x00000020;
+const uint32_t ANIMATION_ACCESS =       0x00000040;
+const uint32_t LABEL_TEXTURE_ACCESS =   0x00000080;
+const uint32_t TIMER_ACCESS =           0x00000100;
+const uint32_t BOUNDS_ACCESS =          0x00000200;
+const uint32_t LABEL_ACCESS =           0x00000400;
+const uint32_t AI_DATA_ACCESS =         0x00000800;
+const uint32_t COLLISION_LAYER_ACCESS = 0x00001000;
+const uint32_t MODEL_MATRIX_ACCESS =    0x00002000;
+const uint32_t LIGHT_ACCESS =           0x00004000;
+// Entity states, signatures and tags, which also drive the query lists
+const uint32_t ENTITY_STATE_ACCESS =    0x00010000;
+const uint32_t ALL_ACCESS =             0xFFFFFFFF;
+
+#endif // COMPONENT_ACCESS_HPP
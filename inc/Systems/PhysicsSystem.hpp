@@ -3,6 +3,13 @@
 
 #include "System.hpp"
 #include "Signatures.hpp"
+#include "CollisionLayers.hpp"
+#include "SpatialHash.hpp"
+#include "StaticBvh.hpp"
+#include "BodyStreams.hpp"
+#include "ContactStream.hpp"
+
+#include <vector>
 
 class PhysicsSystem : public System
 {
@@ -10,10 +17,30 @@ class PhysicsSystem : public System
     PhysicsSystem(MessageBus& message_bus);
     ~PhysicsSystem();
 
+    void SetEntityManager(EntityManager* entity_manager);
+    void BuildStaticColliders();
+    void Update(float delta_time);
     void HandleMessage(Message message);
     void HandleEntity(uint32_t entity_id, float delta_time);
 
     private:
+    struct Collider
+    {
+        uint32_t entity_id;
+        float bounds[6];
+    };
+
+    void BuildBroadphase(float delta_time);
+    void GetColliderBounds(uint32_t entity_id, vec3 min, vec3 max);
+    void GatherCandidates(const vec3 min, const vec3 max);
+    void PostContacts();
+
+    uint32_t m_collision_query_id;
+    SpatialHash* m_broadphase;
+    StaticBvh m_static_colliders;
+    std::vector<Collider> m_candidates;
+    BodyStreams m_body_streams;
+    ContactStream m_contacts;
 };
 
 #endif // PHYSICS_SYSTEM_HPP
\ No newline at end of file
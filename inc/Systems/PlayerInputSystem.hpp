@@ -4,6 +4,10 @@
 #include "System.hpp"
 #include "InputMap.hpp"
 #include "Signatures.hpp"
+#include "CollisionLayers.hpp"
+#include "ContactStream.hpp"
+
+#include <vector>
 
 class PlayerInputSystem : public System
 {
@@ -11,16 +15,32 @@ class PlayerInputSystem : public System
     PlayerInputSystem(MessageBus& message_bus, InputMap& input_map);
     ~PlayerInputSystem();
     
+    void SetEntityManager(EntityManager* entity_manager);
     void HandleMessage(Message message);
     void HandleEntity(uint32_t entity_id, float delta_time);
 
     private:
+    struct Bullet
+    {
+        EntityHandle handle;
+        float lifetime;
+    };
+
+    void SpawnBullet(const Transform& transform);
+    void UpdateBullets(float delta_time);
+
     InputMap& m_input_map;
     double m_prev_mouse_pos_x;
     double m_prev_mouse_pos_y;
     float m_shoot_timer;
-    uint32_t m_num_bullets;
-    uint32_t m_bullet_index;
+    std::vector<Bullet> m_bullets;
+
+    uint32_t m_player_tag_id;
+    uint32_t m_timer_tag_id;
+    uint32_t m_title_tag_id;
+    uint32_t m_win_tag_id;
+    uint32_t m_lose_tag_id;
+    uint32_t m_crosshair_tag_id;
 
     bool m_zoom_on;
     bool m_xray_on;
@@ -5,36 +5,123 @@
 #include "InputMap.hpp"
 #include "linmath.h"
 #include "Signatures.hpp"
+#include "QuadBatch.hpp"
+#include "StaticGeometry.hpp"
+#include "Frustum.hpp"
+#include "LightGrid.hpp"
+#include "ShaderCache.hpp"
+#include "AssetLoader.hpp"
+
+// Work done by the last RenderSystem::Update
+struct RenderStats
+{
+    uint32_t matrix_builds;
+    uint32_t gl_calls;
+    uint32_t draw_calls;
+    uint32_t visible_quads;
+    uint32_t culled_quads;
+};
 
 class RenderSystem : public System
 {
     public:
-    RenderSystem(MessageBus& message_bus, InputMap& input_map);
+    RenderSystem(MessageBus& message_bus, InputMap& input_map, ShaderCache& shader_cache, AssetLoader& asset_loader);
     ~RenderSystem();
 
+    void SetEntityManager(EntityManager* entity_manager);
     void HandleMessage(Message message);
     void HandleEntity(uint32_t entity_id, float delta_time);
     void Update(float delta_time);
+    void SetInterpolationAlpha(float alpha);
+    void BakeStaticGeometry();
+    StaticGeometry& GetStaticGeometry();
+    const RenderStats& GetRenderStats();
 
     private:
+    void GetRenderPosition(uint32_t entity_id, vec3 position);
+    void UpdateFrameConstants();
+    void UpdateLights();
+    void UpdateTextures();
+    void CreateTextureBuffer(uint32_t format, uint32_t texture_unit, uint32_t& buffer, uint32_t& texture);
+    void UploadTextureBuffer(uint32_t buffer, uint32_t size, const void* data);
+    void DrawQuadBatch();
+    void CullStaticGeometry();
+    void DrawStaticGeometry();
+    void DrawQuads(uint32_t first_quad, uint32_t num_quads);
+    void SetVertexLayout();
+    void BuildModelMatrix(const Transform& transform, mat4x4 model_matrix);
+    void GetTextureCoordinates(const Texture& texture, float texture_coordinates[4]);
+
+    // std140 layout of the FrameConstants uniform block
+    struct FrameConstants
+    {
+        mat4x4 view_matrix;
+        mat4x4 perspective_matrix;
+    };
+
+    // std140 layout of the LightGridConstants uniform block, with the cell
+    // size in origin[3]
+    struct LightGridConstants
+    {
+        float origin[4];
+        int32_t dimensions[4];
+    };
+
     InputMap m_input_map;
 
     bool m_zoom_on;
     bool m_xray_on;
 
+    uint32_t m_player_tag_id;
+    float m_interpolation_alpha;
+
     int32_t m_shader_program;
     int32_t m_xray_program;
-    int32_t m_m_location;
-    int32_t m_v_location;
-    int32_t m_p_location;
-    int32_t m_xray_m_location;
-    int32_t m_xray_v_location;
-    int32_t m_xray_p_location;
+    int32_t m_vpos_location;
+    int32_t m_vtexcoord_location;
+    int32_t m_vuselight_location;
+    int32_t m_vlayer_location;
     uint32_t m_texure_sampler_location;
 
-    uint32_t m_texture_slots[7];
-    uint32_t m_textures[7];
-    int32_t m_texture_sizes[7][2];
+    uint32_t m_texture_array;
+    AssetLoader& m_asset_loader;
+    std::vector<uint32_t> m_texture_image_ids;
+    uint32_t m_num_pending_textures;
+    bool m_generate_texture_mipmaps;
+    std::vector<unsigned char> m_layer_pixels;
+
+    QuadBatch m_quad_batch;
+    uint32_t m_vertex_buffer;
+    uint32_t m_index_buffer;
+    uint32_t m_batch_capacity; // in quads
+
+    StaticGeometry m_static_geometry;
+    uint32_t m_static_vertex_buffer;
+    uint32_t m_static_index_buffer;
+    std::vector<uint32_t> m_visible_groups;
+
+    Frustum m_frustum;
+
+    uint32_t m_light_query_id;
+    LightGrid m_light_grid;
+    std::vector<GridLight> m_frame_lights;
+    bool m_lights_valid;
+    uint32_t m_light_grid_constants_buffer;
+    uint32_t m_light_data_buffer;
+    uint32_t m_light_data_texture;
+    uint32_t m_light_cells_buffer;
+    uint32_t m_light_cells_texture;
+    uint32_t m_light_indices_buffer;
+    uint32_t m_light_indices_texture;
+
+    FrameConstants m_frame_constants;
+    uint32_t m_frame_constants_buffer;
+    bool m_frame_constants_valid;
+    bool m_frame_zoom_on;
+    vec3 m_frame_eye;
+    vec3 m_frame_look;
+
+    RenderStats m_render_stats;
     
     vec3 m_eye = { 0, 0, 0 };
     vec3 m_look = { 0, 0, -1 };
@@ -15,5 +15,8 @@ const uint32_t BOUNDS_SYSTEM_SIGNATURE =       0x00000100;
 const uint32_t XRAY_SYSTEM_SIGNATURE =         0x00000200;
 const uint32_t UI_SYSTEM_TEXT_SIGNATURE =      0x00000400;
 const uint32_t UI_SYSTEM_IMAGE_SIGNATURE =     0x00000800;
+// Transform never changes after the level is loaded
+const uint32_t STATIC_SIGNATURE =              0x00001000;
+const uint32_t LIGHT_SIGNATURE =               0x00002000;
 
 #endif // SIGNATURES_HPP
\ No newline at end of file
@@ -1,9 +1,13 @@
 #ifndef SYSTEM_HPP
 #define SYSTEM_HPP
 
+#include <vector>
+
+#include "Message.hpp"
 #include "MessageBus.hpp"
 #include "EntityManager.hpp"
 #include "ComponentManager.hpp"
+#include "ComponentAccess.hpp"
 
 class MessageBus;
 class Message;
@@ -12,18 +16,36 @@ class System
 {
     public:
         System(MessageBus& message_bus, uint32_t system_signature);
-        void SetEntityManager(EntityManager* entity_manager);
+        virtual void SetEntityManager(EntityManager* entity_manager);
         void SetComponentManager(ComponentManager* component_manager);
         virtual void Update(float delta_time);
         virtual void HandleMessage(Message message) = 0;
         virtual void HandleEntity(uint32_t entity_id, float delata_time) = 0;
 
+        // Runs HandleEntity over part of the query. Chunkable systems do all
+        // their per-frame work in HandleEntity and only touch the components
+        // of the entity they are given, so ranges can run on separate threads.
+        void UpdateRange(uint32_t begin, uint32_t end, float delta_time);
+        uint32_t GetNumEntities();
+        uint32_t GetReadAccess();
+        uint32_t GetWriteAccess();
+        bool IsChunkable();
+
     protected:
+        void DeclareAccess(uint32_t read_access, uint32_t write_access, bool chunkable);
+        void Subscribe(MessageType message_type);
+        void MarkTransformChanged(uint32_t entity_id);
+
         MessageBus& m_message_bus;
         EntityManager* m_entity_manager;
         ComponentManager* m_component_manager;
         const uint32_t m_system_signature;
-        
+        uint32_t m_query_id;
+        uint32_t m_read_access;
+        uint32_t m_write_access;
+        bool m_chunkable;
+        std::vector<EntityHandle> m_update_entities; // query copy walked by Update
+
 };
 
 #endif // SYSTEM_HPP
\ No newline at end of file
@@ -5,13 +5,29 @@
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
+#include <vector>
+
 #include "System.hpp"
 #include "Signatures.hpp"
+#include "ShaderCache.hpp"
+#include "AssetLoader.hpp"
+
+struct UIVertexData
+{
+    float x;
+    float y;
+    float z;
+    float r;
+    float g;
+    float b;
+    float u;
+    float v;
+};
 
 class UISystem : public System
 {
     public:
-    UISystem(MessageBus& message_bus, GLFWwindow* window);
+    UISystem(MessageBus& message_bus, GLFWwindow* window, ShaderCache& shader_cache, AssetLoader& asset_loader);
     ~UISystem();
     
     void HandleMessage(Message message);
@@ -19,9 +35,18 @@ class UISystem : public System
     void Update(float delta_time);
 
     private:
+    void AddQuad(const UIVertexData* vertices);
+
     GLFWwindow* m_window;
+    AssetLoader& m_asset_loader;
+    uint32_t m_ui_image_id;
     uint32_t m_shader_program;
+    int32_t m_vpos_location;
+    int32_t m_vcolor_location;
+    int32_t m_vtex_coord_location;
     uint32_t m_ui_texture;
+    uint32_t m_vertex_buffer;
+    std::vector<UIVertexData> m_vertices;
 };
 
 #endif // UI_SYSTEM_HPP
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef ASSET_LOADER_HPP
+#define ASSET_LOADER_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "JobSystem.hpp"
+#include "MappedFile.hpp"
+#include "TextureContainer.hpp"
+
+const uint32_t invalid_image_id = 0xFFFFFFFF;
+
+struct ImageMip
+{
+    int32_t width;
+    int32_t height;
+    const unsigned char* pixels;
+};
+
+// Decodes images on the job system so startup waits on the slowest image
+// instead of all of them in turn. An image with a precooked .tex container
+// next to it is memory mapped instead of decoded, mips included. The thread
+// that owns GL polls IsImageReady and uploads finished pixels itself,
+// keeping placeholders until then. benchmarks/asset_loader_check runs both
+// paths with no window.
+class AssetLoader
+{
+    public:
+    AssetLoader(JobSystem& job_system);
+    ~AssetLoader();
+
+    // Queues a decode and returns its id right away. Images are flipped so
+    // the first row is the bottom one, as GL expects.
+    uint32_t LoadImage(const char* path, uint32_t num_channels);
+
+    // True once the decode finished, successfully or not
+    bool IsImageReady(uint32_t image_id);
+    // NULL if the decode failed
+    const unsigned char* GetImagePixels(uint32_t image_id);
+    int32_t GetImageWidth(uint32_t image_id);
+    int32_t GetImageHeight(uint32_t image_id);
+    // Decoded images only have level 0, containers have the full chain
+    uint32_t GetImageNumMips(uint32_t image_id);
+    ImageMip GetImageMip(uint32_t image_id, uint32_t level);
+    // Releases the pixels once they have been uploaded
+    void FreeImage(uint32_t image_id);
+
+    void WaitAll();
+    uint32_t GetNumPendingImages();
+
+    private:
+    struct ImageRequest
+    {
+        std::string path;
+        uint32_t num_channels;
+        int32_t width;
+        int32_t height;
+        unsigned char* pixels;
+        MappedFile container;
+        const TextureContainerMip* mips;
+        uint32_t num_mips;
+        std::atomic<bool> ready;
+    };
+
+    static void DecodeImage(void* data, uint32_t begin, uint32_t end);
+    static bool MapContainer(ImageRequest* image);
+
+    JobSystem& m_job_system;
+    JobCounter m_counter;
+    std::vector<ImageRequest*> m_images;
+};
+
+#endif // ASSET_LOADER_HPP
@@ -0,0 +1,33 @@
+#ifndef SIMULATION_CLOCK_HPP
+#define SIMULATION_CLOCK_HPP
+
+#include <stdint.h>
+
+// Fixed timestep clock. Frame time is accumulated in whole nanoseconds so
+// the number of steps taken never depends on float rounding. Each frame can
+// run at most max_steps_per_frame steps. Time beyond that is dropped, so a
+// slow frame cannot make the next frame slower too.
+class SimulationClock
+{
+    public:
+    SimulationClock(uint32_t steps_per_second, uint32_t max_steps_per_frame);
+    ~SimulationClock();
+
+    void Advance(uint64_t elapsed_nanoseconds);
+    bool Step();
+
+    float GetStepTime();
+    // Fraction of a step left in the accumulator, used to blend the last
+    // two simulated states when rendering
+    float GetAlpha();
+    uint64_t GetNumDroppedSteps();
+
+    private:
+    const uint64_t m_step_nanoseconds;
+    const uint32_t m_max_steps_per_frame;
+    uint64_t m_accumulator;
+    uint32_t m_num_frame_steps;
+    uint64_t m_num_dropped_steps;
+};
+
+#endif // SIMULATION_CLOCK_HPP
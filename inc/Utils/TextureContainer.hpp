@@ -0,0 +1,51 @@
+#ifndef TEXTURE_CONTAINER_HPP
+#define TEXTURE_CONTAINER_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Precooked texture file written by texture_builder. A header, then one
+// entry per mip level, then the pixels of every level. Rows are stored
+// bottom first, as GL expects, so the payload uploads as is.
+const uint32_t texture_container_magic = 0x58455458; // XTEX
+const uint32_t texture_container_version = 1;
+
+enum TextureContainerFormat
+{
+    TEXTURE_FORMAT_R8 = 1,
+    TEXTURE_FORMAT_RG8 = 2,
+    TEXTURE_FORMAT_RGB8 = 3,
+    TEXTURE_FORMAT_RGBA8 = 4
+};
+
+struct TextureContainerHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t num_channels;
+    uint32_t format;
+    uint32_t num_mips;
+    uint32_t reserved;
+};
+
+// Offset is from the start of the file
+struct TextureContainerMip
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t offset;
+    uint32_t size;
+};
+
+// Builds a container holding pixels and their full box filtered mip chain
+void WriteTextureContainer(const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t num_channels,
+                           std::vector<unsigned char>& container);
+
+// Checks that data holds a complete container and points at its mip table
+bool ReadTextureContainer(const unsigned char* data, size_t size,
+                          const TextureContainerHeader*& header, const TextureContainerMip*& mips);
+
+#endif // TEXTURE_CONTAINER_HPP
@@ -6,6 +6,11 @@
 AISystem::AISystem(MessageBus& message_bus) : 
     System(message_bus, AI_SYSTEM_SIGNATURE)
 {
+    DeclareAccess(AI_DATA_ACCESS | ENTITY_STATE_ACCESS,
+                  TRANSFORM_ACCESS | RIGID_BODY_ACCESS | ANIMATION_ACCESS | TEXTURE_ACCESS | MODEL_MATRIX_ACCESS,
+                  true);
+    Subscribe(COLLISION);
+    Subscribe(RESTART);
 }
 
 AISystem::~AISystem()
@@ -16,37 +21,44 @@ void AISystem::HandleMessage(Message message)
 {
     if(message.message_type == MessageType::COLLISION)
     {
-        
-        uint32_t entity_1_id = message.message_data >> 16;
-        uint32_t entity_2_id = message.message_data & 0x0000FFFF;
+        const ContactStreamPayload* contacts = (const ContactStreamPayload*)message.payload;
+        for(uint32_t i = 0; i < contacts->num_contacts; i++)
+        {
+            if(!m_entity_manager->IsAlive(contacts->entity_ids[i]) || !m_entity_manager->IsAlive(contacts->other_entity_ids[i]))
+            {
+                continue;
+            }
+            uint32_t entity_1_id = GetEntityIndex(contacts->entity_ids[i]);
+            uint32_t entity_2_id = GetEntityIndex(contacts->other_entity_ids[i]);
 
-        char* entity_1_tag = m_entity_manager->GetEntityTag(entity_1_id);
-        char* entity_2_tag = m_entity_manager->GetEntityTag(entity_2_id);
+            uint32_t entity_1_category = m_component_manager->GetComponent<CollisionLayer>(entity_1_id).category;
 
-        if(strcmp(entity_1_tag, "enemy") == 0)
-        {
-            uint32_t enemy_id = entity_1_id;
-            RigidBody& rigid_body = m_component_manager->GetComponent<RigidBody>(enemy_id);
-            AIData& ai_data = m_component_manager->GetComponent<AIData>(enemy_id);
-            ai_data.speed = -ai_data.speed;
-            rigid_body.velocity[0] = ai_data.speed;
-            Texture& texture = m_component_manager->GetComponent<Texture>(enemy_id);
-            if(ai_data.speed > 0)
+            if(entity_1_category & ENEMY_COLLISION_LAYER)
             {
-                texture.position[1] = 0;
+                uint32_t enemy_id = entity_1_id;
+                RigidBody& rigid_body = m_component_manager->GetComponent<RigidBody>(enemy_id);
+                AIData& ai_data = m_component_manager->GetComponent<AIData>(enemy_id);
+                ai_data.speed = -ai_data.speed;
+                rigid_body.velocity[0] = ai_data.speed;
+                Texture& texture = m_component_manager->GetComponent<Texture>(enemy_id);
+                if(ai_data.speed > 0)
+                {
+                    texture.position[1] = 0;
+                }
+                else
+                {
+                    texture.position[1] = 128;
+                }
             }
-            else
+            else if(entity_1_category & BULLET_COLLISION_LAYER &&
+                    m_component_manager->HasComponent<AIData>(entity_2_id))
             {
-                texture.position[1] = 128;
+                RigidBody& rigid_body = m_component_manager->GetComponent<RigidBody>(entity_2_id);
+                AIData& ai_data = m_component_manager->GetComponent<AIData>(entity_2_id);
+                rigid_body.velocity[0] = 0;
+                ai_data.alive = false;
             }
         }
-        else if(strncmp(entity_1_tag, "bullet", 6) == 0)
-        {
-            RigidBody& rigid_body = m_component_manager->GetComponent<RigidBody>(entity_2_id);
-            AIData& ai_data = m_component_manager->GetComponent<AIData>(entity_2_id);
-            rigid_body.velocity[0] = 0;
-            ai_data.alive = false;
-        }
     }
     if(message.message_type == MessageType::RESTART)
     {
@@ -61,11 +73,15 @@ void AISystem::HandleMessage(Message message)
                 transform.position[0] = ai_data.position[0];
                 transform.position[1] = ai_data.position[1];
                 transform.position[2] = ai_data.position[2];
+                rigid_body.previous_position[0] = ai_data.position[0];
+                rigid_body.previous_position[1] = ai_data.position[1];
+                rigid_body.previous_position[2] = ai_data.position[2];
                 transform.rotation[0] = ai_data.rotation[0];
                 transform.rotation[1] = ai_data.rotation[1];
                 transform.rotation[2] = ai_data.rotation[2];
                 rigid_body.velocity[0] = ai_data.speed;
                 ai_data.alive = true;
+                MarkTransformChanged(i);
             }
         }
     }
@@ -98,6 +114,8 @@ void AISystem::HandleEntity(uint32_t entity_id, float delta_time)
     {
         transform.rotation[0] -= 100 * delta_time;
         transform.position[1] = ai_data.initial_height - 0.70 * -(1 - ((90 - transform.rotation[0]) / 90));
+        rigid_body.previous_position[1] = transform.position[1];
+        MarkTransformChanged(entity_id);
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include <cstdio>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "AssetLoader.hpp"
+
+AssetLoader::AssetLoader(JobSystem& job_system) :
+    m_job_system(job_system),
+    m_counter(0)
+{
+
+}
+
+AssetLoader::~AssetLoader()
+{
+    WaitAll();
+    for(uint32_t i = 0; i < m_images.size(); i++)
+    {
+        FreeImage(i);
+        delete m_images[i];
+    }
+}
+
+uint32_t AssetLoader::LoadImage(const char* path, uint32_t num_channels)
+{
+    ImageRequest* image = new ImageRequest;
+    image->path = path;
+    image->num_channels = num_channels;
+    image->width = 0;
+    image->height = 0;
+    image->pixels = NULL;
+    image->mips = NULL;
+    image->num_mips = 0;
+    image->ready = false;
+
+    uint32_t image_id = m_images.size();
+    m_images.push_back(image);
+    m_job_system.Submit(DecodeImage, image, 0, 1, m_counter);
+    return image_id;
+}
+
+bool AssetLoader::IsImageReady(uint32_t image_id)
+{
+    // Worker 0 only runs jobs while it waits, so a single threaded job system
+    // decodes everything on the first poll
+    if(m_job_system.GetNumThreads() == 1)
+    {
+        WaitAll();
+    }
+    return m_images[image_id]->ready.load(std::memory_order_acquire);
+}
+
+const unsigned char* AssetLoader::GetImagePixels(uint32_t image_id)
+{
+    ImageRequest* image = m_images[image_id];
+    if(image->mips != NULL)
+    {
+        return image->container.GetData() + image->mips[0].offset;
+    }
+    return image->pixels;
+}
+
+int32_t AssetLoader::GetImageWidth(uint32_t image_id)
+{
+    return m_images[image_id]->width;
+}
+
+int32_t AssetLoader::GetImageHeight(uint32_t image_id)
+{
+    return m_images[image_id]->height;
+}
+
+uint32_t AssetLoader::GetImageNumMips(uint32_t image_id)
+{
+    return m_images[image_id]->num_mips;
+}
+
+ImageMip AssetLoader::GetImageMip(uint32_t image_id, uint32_t level)
+{
+    ImageRequest* image = m_images[image_id];
+    ImageMip mip;
+    if(image->mips != NULL)
+    {
+        mip.width = image->mips[level].width;
+        mip.height = image->mips[level].height;
+        mip.pixels = image->container.GetData() + image->mips[level].offset;
+    }
+    else
+    {
+        mip.width = image->width;
+        mip.height = image->height;
+        mip.pixels = image->pixels;
+    }
+    return mip;
+}
+
+void AssetLoader::FreeImage(uint32_t image_id)
+{
+    ImageRequest* image = m_images[image_id];
+    if(image->pixels != NULL)
+    {
+        stbi_image_free(image->pixels);
+        image->pixels = NULL;
+    }
+    image->container.Close();
+    image->mips = NULL;
+    image->num_mips = 0;
+}
+
+void AssetLoader::WaitAll()
+{
+    m_job_system.Wait(m_counter);
+}
+
+uint32_t AssetLoader::GetNumPendingImages()
+{
+    return m_counter;
+}
+
+void AssetLoader::DecodeImage(void* data, uint32_t /*begin*/, uint32_t /*end*/)
+{
+    ImageRequest* image = (ImageRequest*)data;
+
+    if(MapContainer(image))
+    {
+        image->ready.store(true, std::memory_order_release);
+        return;
+    }
+
+    // The flip flag is global unless set per thread
+    stbi_set_flip_vertically_on_load_thread(true);
+    int32_t num_channels;
+    image->pixels = stbi_load(image->path.c_str(), &image->width, &image->height, &num_channels, image->num_channels);
+    if(image->pixels == NULL)
+    {
+        printf("Failed to load %s: %s\n", image->path.c_str(), stbi_failure_reason());
+    }
+    else
+    {
+        image->num_mips = 1;
+    }
+    image->ready.store(true, std::memory_order_release);
+}
+
+// Looks for the image's .tex container, which texture_builder writes next
+// to the source image. Containers with other channel counts are skipped.
+bool AssetLoader::MapContainer(ImageRequest* image)
+{
+    std::string container_path = image->path;
+    size_t extension = container_path.find_last_of('.');
+    if(extension != std::string::npos)
+    {
+        container_path.erase(extension);
+    }
+    container_path += ".tex";
+
+    if(!image->container.Open(container_path.c_str()))
+    {
+        return false;
+    }
+
+    const TextureContainerHeader* header;
+    const TextureContainerMip* mips;
+    if(!ReadTextureContainer(image->container.GetData(), image->container.GetSize(), header, mips) ||
+       header->num_channels != image->num_channels)
+    {
+        printf("Ignoring %s, decoding %s instead\n", container_path.c_str(), image->path.c_str());
+        image->container.Close();
+        return false;
+    }
+
+    image->width = header->width;
+    image->height = header->height;
+    image->mips = mips;
+    image->num_mips = header->num_mips;
+    return true;
+}
@@ -0,0 +1,122 @@
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+#include "BodyStreams.hpp"
+
+static void IntegrateStream(uint32_t num_bodies, float delta_time, float* position, float* velocity, const float* acceleration)
+{
+    uint32_t i = 0;
+
+#if defined(__AVX__)
+    __m256 dt8 = _mm256_set1_ps(delta_time);
+    for(; i + 8 <= num_bodies; i += 8)
+    {
+        __m256 v = _mm256_add_ps(_mm256_loadu_ps(velocity + i), _mm256_loadu_ps(acceleration + i));
+        __m256 p = _mm256_add_ps(_mm256_loadu_ps(position + i), _mm256_mul_ps(v, dt8));
+        _mm256_storeu_ps(velocity + i, v);
+        _mm256_storeu_ps(position + i, p);
+    }
+#endif
+
+#if defined(__AVX__) || defined(__SSE__) || defined(_M_X64)
+    __m128 dt4 = _mm_set1_ps(delta_time);
+    for(; i + 4 <= num_bodies; i += 4)
+    {
+        __m128 v = _mm_add_ps(_mm_loadu_ps(velocity + i), _mm_loadu_ps(acceleration + i));
+        __m128 p = _mm_add_ps(_mm_loadu_ps(position + i), _mm_mul_ps(v, dt4));
+        _mm_storeu_ps(velocity + i, v);
+        _mm_storeu_ps(position + i, p);
+    }
+#endif
+
+    for(; i < num_bodies; i++)
+    {
+        velocity[i] += acceleration[i];
+        position[i] += velocity[i] * delta_time;
+    }
+}
+
+
+BodyStreams::BodyStreams()
+{
+
+}
+
+BodyStreams::~BodyStreams()
+{
+
+}
+
+void BodyStreams::Clear()
+{
+    m_entity_ids.clear();
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        m_position[i].clear();
+        m_velocity[i].clear();
+        m_acceleration[i].clear();
+    }
+}
+
+void BodyStreams::AddBody(uint32_t entity_id, const vec3 position, const vec3 velocity, const vec3 acceleration)
+{
+    m_entity_ids.push_back(entity_id);
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        m_position[i].push_back(position[i]);
+        m_velocity[i].push_back(velocity[i]);
+        m_acceleration[i].push_back(acceleration[i]);
+    }
+}
+
+void BodyStreams::Integrate(float delta_time)
+{
+    uint32_t num_bodies = m_entity_ids.size();
+    if(num_bodies == 0)
+    {
+        return;
+    }
+
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        IntegrateStream(num_bodies, delta_time, &m_position[i][0], &m_velocity[i][0], &m_acceleration[i][0]);
+    }
+}
+
+uint32_t BodyStreams::GetNumBodies()
+{
+    return m_entity_ids.size();
+}
+
+uint32_t BodyStreams::GetEntityId(uint32_t index)
+{
+    return m_entity_ids[index];
+}
+
+void BodyStreams::GetPosition(uint32_t index, vec3 position)
+{
+    position[0] = m_position[0][index];
+    position[1] = m_position[1][index];
+    position[2] = m_position[2][index];
+}
+
+void BodyStreams::GetVelocity(uint32_t index, vec3 velocity)
+{
+    velocity[0] = m_velocity[0][index];
+    velocity[1] = m_velocity[1][index];
+    velocity[2] = m_velocity[2][index];
+}
+
+const char* BodyStreams::GetIntegrationPath()
+{
+#if defined(__AVX__)
+    return "AVX";
+#elif defined(__SSE__) || defined(_M_X64)
+    return "SSE";
+#else
+    return "scalar";
+#endif
+}
@@ -12,7 +12,10 @@ ComponentManager::ComponentManager(uint32_t num_entities) : m_transform_pool(num
                                                             m_timer_pool(num_entities),
                                                             m_bounds_pool(num_entities),
                                                             m_label_pool(num_entities),
-                                                            m_ai_data_pool(num_entities)
+                                                            m_ai_data_pool(num_entities),
+                                                            m_collision_layer_pool(num_entities),
+                                                            m_model_matrix_pool(num_entities),
+                                                            m_light_pool(num_entities)
 {
 
 }
@@ -22,146 +25,111 @@ ComponentManager::~ComponentManager()
 
 }
 
-template <>
-void ComponentManager::AddComponent<Transform>(uint32_t entity_id, Transform component)
-{
-    m_transform_pool.AddComponent(entity_id, component);
-}
-
-template <>
-Transform& ComponentManager::GetComponent<Transform>(uint32_t entity_id)
-{
-    return m_transform_pool.GetComponent(entity_id);
-}
-
-template <>
-void ComponentManager::AddComponent<RigidBody>(uint32_t entity_id, RigidBody component)
-{
-    m_rigid_body_pool.AddComponent(entity_id, component);
-}
-
-template <>
-RigidBody& ComponentManager::GetComponent<RigidBody>(uint32_t entity_id)
-{
-    return m_rigid_body_pool.GetComponent(entity_id);
-}
-
-template <>
-void ComponentManager::AddComponent<Texture>(uint32_t entity_id, Texture component)
-{
-    m_texture_pool.AddComponent(entity_id, component);
-}
-
-template <>
-Texture& ComponentManager::GetComponent<Texture>(uint32_t entity_id)
-{
-    return m_texture_pool.GetComponent(entity_id);
-}
-
-template <>
-void ComponentManager::AddComponent<PlayerInput>(uint32_t entity_id, PlayerInput component)
-{
-    m_player_input_pool.AddComponent(entity_id, component);
-}
-
-template <>
-PlayerInput& ComponentManager::GetComponent<PlayerInput>(uint32_t entity_id)
+void ComponentManager::RemoveAllComponents(uint32_t entity_id)
 {
-    return m_player_input_pool.GetComponent(entity_id);
+    m_transform_pool.RemoveComponent(entity_id);
+    m_texture_pool.RemoveComponent(entity_id);
+    m_rigid_body_pool.RemoveComponent(entity_id);
+    m_player_input_pool.RemoveComponent(entity_id);
+    m_bounding_box_pool.RemoveComponent(entity_id);
+    m_quad_pool.RemoveComponent(entity_id);
+    m_animation_pool.RemoveComponent(entity_id);
+    m_label_texture_pool.RemoveComponent(entity_id);
+    m_timer_pool.RemoveComponent(entity_id);
+    m_bounds_pool.RemoveComponent(entity_id);
+    m_label_pool.RemoveComponent(entity_id);
+    m_ai_data_pool.RemoveComponent(entity_id);
+    m_collision_layer_pool.RemoveComponent(entity_id);
+    m_model_matrix_pool.RemoveComponent(entity_id);
+    m_light_pool.RemoveComponent(entity_id);
 }
 
 template <>
-void ComponentManager::AddComponent<BoundingBox>(uint32_t entity_id, BoundingBox component)
+ComponentPool<Transform>& ComponentManager::GetComponentPool<Transform>()
 {
-    m_bounding_box_pool.AddComponent(entity_id, component);
+    return m_transform_pool;
 }
 
 template <>
-BoundingBox& ComponentManager::GetComponent<BoundingBox>(uint32_t entity_id)
+ComponentPool<RigidBody>& ComponentManager::GetComponentPool<RigidBody>()
 {
-    return m_bounding_box_pool.GetComponent(entity_id);
+    return m_rigid_body_pool;
 }
 
 template <>
-void ComponentManager::AddComponent<Quad>(uint32_t entity_id, Quad component)
+ComponentPool<Texture>& ComponentManager::GetComponentPool<Texture>()
 {
-    m_quad_pool.AddComponent(entity_id, component);
+    return m_texture_pool;
 }
 
 template <>
-Quad& ComponentManager::GetComponent<Quad>(uint32_t entity_id)
+ComponentPool<PlayerInput>& ComponentManager::GetComponentPool<PlayerInput>()
 {
-    return m_quad_pool.GetComponent(entity_id);
+    return m_player_input_pool;
 }
 
 template <>
-void ComponentManager::AddComponent<Animation>(uint32_t entity_id, Animation component)
+ComponentPool<BoundingBox>& ComponentManager::GetComponentPool<BoundingBox>()
 {
-    m_animation_pool.AddComponent(entity_id, component);
+    return m_bounding_box_pool;
 }
 
 template <>
-Animation& ComponentManager::GetComponent<Animation>(uint32_t entity_id)
+ComponentPool<Quad>& ComponentManager::GetComponentPool<Quad>()
 {
-    return m_animation_pool.GetComponent(entity_id);
+    return m_quad_pool;
 }
 
 template <>
-void ComponentManager::AddComponent<LabelTexture>(uint32_t entity_id, LabelTexture component)
+ComponentPool<Animation>& ComponentManager::GetComponentPool<Animation>()
 {
-    m_label_texture_pool.AddComponent(entity_id, component);
+    return m_animation_pool;
 }
 
 template <>
-LabelTexture& ComponentManager::GetComponent<LabelTexture>(uint32_t entity_id)
+ComponentPool<LabelTexture>& ComponentManager::GetComponentPool<LabelTexture>()
 {
-    return m_label_texture_pool.GetComponent(entity_id);
+    return m_label_texture_pool;
 }
 
 template <>
-void ComponentManager::AddComponent<Timer>(uint32_t entity_id, Timer component)
+ComponentPool<Timer>& ComponentManager::GetComponentPool<Timer>()
 {
-    m_timer_pool.AddComponent(entity_id, component);
+    return m_timer_pool;
 }
 
 template <>
-Timer& ComponentManager::GetComponent<Timer>(uint32_t entity_id)
+ComponentPool<Bounds>& ComponentManager::GetComponentPool<Bounds>()
 {
-    return m_timer_pool.GetComponent(entity_id);
+    return m_bounds_pool;
 }
 
 template <>
-void ComponentManager::AddComponent<Bounds>(uint32_t entity_id, Bounds component)
+ComponentPool<Label>& ComponentManager::GetComponentPool<Label>()
 {
-    m_bounds_pool.AddComponent(entity_id, component);
+    return m_label_pool;
 }
 
 template <>
-Bounds& ComponentManager::GetComponent<Bounds>(uint32_t entity_id)
+ComponentPool<AIData>& ComponentManager::GetComponentPool<AIData>()
 {
-    return m_bounds_pool.GetComponent(entity_id);
+    return m_ai_data_pool;
 }
 
 template <>
-void ComponentManager::AddComponent<Label>(uint32_t entity_id, Label component)
+ComponentPool<CollisionLayer>& ComponentManager::GetComponentPool<CollisionLayer>()
 {
-    m_label_pool.AddComponent(entity_id, component);
+    return m_collision_layer_pool;
 }
 
 template <>
-Label& ComponentManager::GetComponent<Label>(uint32_t entity_id)
+ComponentPool<ModelMatrix>& ComponentManager::GetComponentPool<ModelMatrix>()
 {
-    return m_label_pool.GetComponent(entity_id);
+    return m_model_matrix_pool;
 }
 
 template <>
-void ComponentManager::AddComponent<AIData>(uint32_t entity_id, AIData component)
+ComponentPool<Light>& ComponentManager::GetComponentPool<Light>()
 {
-    m_ai_data_pool.AddComponent(entity_id, component);
+    return m_light_pool;
 }
-
-template <>
-AIData& ComponentManager::GetComponent<AIData>(uint32_t entity_id)
-{
-    return m_ai_data_pool.GetComponent(entity_id);
-}
\ No newline at end of file
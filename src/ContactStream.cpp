@@ -0,0 +1,83 @@
+#include <cstring>
+
+#include "ContactStream.hpp"
+
+ContactStream::ContactStream()
+{
+
+}
+
+ContactStream::~ContactStream()
+{
+
+}
+
+void ContactStream::Clear()
+{
+    m_entity_ids.clear();
+    m_other_entity_ids.clear();
+    for(uint32_t axis = 0; axis < 3; axis++)
+    {
+        m_normals[axis].clear();
+    }
+    m_times_of_impact.clear();
+}
+
+void ContactStream::AddContact(uint32_t entity_id, uint32_t other_entity_id, const vec3 normal, float time_of_impact)
+{
+    m_entity_ids.push_back(entity_id);
+    m_other_entity_ids.push_back(other_entity_id);
+    for(uint32_t axis = 0; axis < 3; axis++)
+    {
+        m_normals[axis].push_back(normal[axis]);
+    }
+    m_times_of_impact.push_back(time_of_impact);
+}
+
+uint32_t ContactStream::GetNumContacts()
+{
+    return m_entity_ids.size();
+}
+
+uint32_t ContactStream::GetPayloadSize()
+{
+    // Every stream is 4 bytes per contact so they stay aligned back to back
+    return sizeof(ContactStreamPayload) + GetNumContacts() * (2 * sizeof(uint32_t) + 4 * sizeof(float));
+}
+
+const ContactStreamPayload* ContactStream::WritePayload(void* memory)
+{
+    uint32_t num_contacts = GetNumContacts();
+    ContactStreamPayload* payload = (ContactStreamPayload*)memory;
+    char* stream = (char*)memory + sizeof(ContactStreamPayload);
+
+    payload->num_contacts = num_contacts;
+    if(num_contacts == 0)
+    {
+        payload->entity_ids = 0;
+        payload->other_entity_ids = 0;
+        payload->normals[0] = payload->normals[1] = payload->normals[2] = 0;
+        payload->times_of_impact = 0;
+        return payload;
+    }
+
+    memcpy(stream, &m_entity_ids[0], num_contacts * sizeof(uint32_t));
+    payload->entity_ids = (const uint32_t*)stream;
+    stream += num_contacts * sizeof(uint32_t);
+
+    memcpy(stream, &m_other_entity_ids[0], num_contacts * sizeof(uint32_t));
+    payload->other_entity_ids = (const uint32_t*)stream;
+    stream += num_contacts * sizeof(uint32_t);
+
+    for(uint32_t axis = 0; axis < 3; axis++)
+    {
+        memcpy(stream, &m_normals[axis][0], num_contacts * sizeof(float));
+        payload->normals[axis] = (const float*)stream;
+        stream += num_contacts * sizeof(float);
+    }
+
+    memcpy(stream, &m_times_of_impact[0], num_contacts * sizeof(float));
+    payload->times_of_impact = (const float*)stream;
+
+    return payload;
+}
@@ -1,45 +1,220 @@
 #include <cstring>
+#include <cstdio>
 
 #include "EntityManager.hpp"
 
+static uint32_t HashTag(const char* tag)
+{
+    // 32 bit FNV-1a
+    uint32_t hash = 2166136261u;
+    for(uint32_t i = 0; i < tag_length && tag[i] != '\0'; i++)
+    {
+        hash ^= (uint8_t)tag[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t GetTagTableSize(uint32_t max_num_tags)
+{
+    // Keep the load factor at or below one half
+    uint32_t table_size = 16;
+    while(table_size < max_num_tags * 2)
+    {
+        table_size *= 2;
+    }
+    return table_size;
+}
+
+// Reallocates an array for more entities, zeroing the new entries
+template <typename T>
+static void GrowArray(T*& array, uint32_t size, uint32_t new_size)
+{
+    T* grown_array = new T[new_size];
+    memcpy(grown_array, array, size * sizeof(T));
+    memset(grown_array + size, 0, (new_size - size) * sizeof(T));
+    delete[] array;
+    array = grown_array;
+}
+
 EntityManager::EntityManager(uint32_t num_entities) : m_num_entities(num_entities),
                                                     m_entity_signatures(new uint32_t[num_entities]),
-                                                    m_entity_tags(new char*[num_entities]),
-                                                    m_entity_states(new EntityState[num_entities])
+                                                    m_entity_states(new EntityState[num_entities]),
+                                                    m_num_used_entities(0),
+                                                    m_entity_generations(new uint32_t[num_entities]),
+                                                    m_entity_alive(new bool[num_entities]),
+                                                    m_num_free_entities(0),
+                                                    m_free_entities(new uint32_t[num_entities]),
+                                                    m_num_queries(0),
+                                                    m_query_membership(new uint32_t[num_entities]),
+                                                    m_max_num_tags(num_entities * 2),
+                                                    m_num_tags(0),
+                                                    m_tag_names(new char[num_entities * 2 * tag_length]),
+                                                    m_tag_hashes(new uint32_t[num_entities * 2]),
+                                                    m_tag_entities(new uint32_t[num_entities * 2]),
+                                                    m_tag_pinned(new bool[num_entities * 2]),
+                                                    m_num_free_tags(0),
+                                                    m_free_tags(new uint32_t[num_entities * 2]),
+                                                    m_tag_table_mask(GetTagTableSize(num_entities * 2) - 1),
+                                                    m_tag_table(new uint32_t[GetTagTableSize(num_entities * 2)]),
+                                                    m_entity_tag_ids(new uint32_t[num_entities]),
+                                                    m_entity_tag_next(new uint32_t[num_entities]),
+                                                    m_entity_tag_previous(new uint32_t[num_entities])
 {
     memset(m_entity_signatures, 0, num_entities * sizeof(uint32_t));
     memset(m_entity_states, 0, num_entities * sizeof(EntityState));
-    for(uint32_t i = 0; i < num_entities; i++)
-    {
-        m_entity_tags[i] = new char[tag_length];
-        memset(m_entity_tags[i], 0, tag_length);
-    }
+    memset(m_entity_generations, 0, num_entities * sizeof(uint32_t));
+    memset(m_entity_alive, 0, num_entities * sizeof(bool));
+    memset(m_query_membership, 0, num_entities * sizeof(uint32_t));
+    memset(m_tag_table, 0, (m_tag_table_mask + 1) * sizeof(uint32_t));
+    memset(m_entity_tag_ids, 0, num_entities * sizeof(uint32_t));
+    memset(m_entity_tag_next, 0, num_entities * sizeof(uint32_t));
+    memset(m_entity_tag_previous, 0, num_entities * sizeof(uint32_t));
+
+    // Tag id 0 is the empty tag every entity starts with
+    GetTagId("");
 }
 
 EntityManager::~EntityManager()
 {
     delete[] m_entity_signatures;
     delete[] m_entity_states;
-    for(uint32_t i = 0; i < m_num_entities; i++)
+    delete[] m_entity_generations;
+    delete[] m_entity_alive;
+    delete[] m_free_entities;
+    for(uint32_t i = 0; i < m_num_queries; i++)
+    {
+        delete[] m_query_entities[i];
+        delete[] m_query_positions[i];
+    }
+    delete[] m_query_membership;
+    delete[] m_tag_names;
+    delete[] m_tag_hashes;
+    delete[] m_tag_entities;
+    delete[] m_tag_pinned;
+    delete[] m_free_tags;
+    delete[] m_tag_table;
+    delete[] m_entity_tag_ids;
+    delete[] m_entity_tag_next;
+    delete[] m_entity_tag_previous;
+}
+
+EntityHandle EntityManager::Create()
+{
+    uint32_t entity_id;
+    if(m_num_free_entities > 0)
     {
-        delete[] m_entity_tags[i];
+        entity_id = m_free_entities[--m_num_free_entities];
     }
-    delete[] m_entity_tags;
+    else
+    {
+        if(m_num_used_entities >= max_num_entities)
+        {
+            printf("TOO MANY ENTITIES\n");
+            return invalid_entity_handle;
+        }
+        if(m_num_used_entities == m_num_entities)
+        {
+            uint32_t num_entities = m_num_entities + entity_chunk_size;
+            if(num_entities > max_num_entities)
+            {
+                num_entities = max_num_entities;
+            }
+            Grow(num_entities);
+        }
+        entity_id = m_num_used_entities++;
+    }
+
+    m_entity_alive[entity_id] = true;
+    return GetEntityHandle(entity_id);
+}
+
+void EntityManager::Destroy(EntityHandle handle)
+{
+    if(!IsAlive(handle))
+    {
+        return;
+    }
+
+    uint32_t entity_id = GetEntityIndex(handle);
+    m_entity_states[entity_id] = EntityState::INACTIVE;
+    m_entity_signatures[entity_id] = 0;
+    UpdateQueries(entity_id);
+    if(m_entity_tag_ids[entity_id] != 0)
+    {
+        SetEntityTag(entity_id, "");
+    }
+
+    // Every handle to the old occupant goes stale here
+    m_entity_alive[entity_id] = false;
+    m_entity_generations[entity_id] = (m_entity_generations[entity_id] + 1) & entity_generation_mask;
+    m_free_entities[m_num_free_entities++] = entity_id;
+}
+
+bool EntityManager::IsAlive(EntityHandle handle)
+{
+    uint32_t entity_id = GetEntityIndex(handle);
+    return entity_id < m_num_entities && m_entity_alive[entity_id] &&
+           m_entity_generations[entity_id] == GetEntityGeneration(handle);
+}
+
+EntityHandle EntityManager::GetEntityHandle(uint32_t entity_id)
+{
+    if(entity_id >= m_num_entities)
+    {
+        return invalid_entity_handle;
+    }
+    return (m_entity_generations[entity_id] << entity_index_bits) | entity_id;
+}
+
+uint32_t EntityManager::GetNumAliveEntities()
+{
+    return m_num_used_entities - m_num_free_entities;
 }
 
 void EntityManager::SetEntitySignature(uint32_t entity_id, uint32_t signature)
 {
+    if(entity_id >= m_num_entities)
+    {
+        return;
+    }
     m_entity_signatures[entity_id] = signature;
+    UpdateQueries(entity_id);
 }
 
 void EntityManager::SetEntityState(uint32_t entity_id, EntityState state)
 {
+    if(entity_id >= m_num_entities)
+    {
+        return;
+    }
     m_entity_states[entity_id] = state;
+    UpdateQueries(entity_id);
 }
 
-void EntityManager::SetEntityTag(uint32_t entity_id, char* tag)
+void EntityManager::SetEntityTag(uint32_t entity_id, const char* tag)
 {
-    strncpy(m_entity_tags[entity_id], tag, tag_length);
+    if(entity_id >= m_num_entities)
+    {
+        return;
+    }
+
+    uint32_t tag_id = InternTag(tag);
+    if(tag_id == invalid_tag_id)
+    {
+        return;
+    }
+
+    // Relinking at the head keeps the most recent holder first, and the old
+    // tag passes to whichever entity was given it before this one
+    uint32_t old_tag_id = m_entity_tag_ids[entity_id];
+    UnlinkTagHolder(entity_id);
+    m_entity_tag_ids[entity_id] = tag_id;
+    LinkTagHolder(entity_id);
+    if(old_tag_id != tag_id)
+    {
+        ReleaseTag(old_tag_id);
+    }
 }
 
 uint32_t EntityManager::GetNumEntities()
@@ -49,28 +224,342 @@ uint32_t EntityManager::GetNumEntities()
 
 uint32_t EntityManager::GetEntitySignature(uint32_t entity_id)
 {
+    if(entity_id >= m_num_entities)
+    {
+        return 0;
+    }
     return m_entity_signatures[entity_id];
 }
 
 EntityState EntityManager::GetEntityState(uint32_t entity_id)
 {
+    if(entity_id >= m_num_entities)
+    {
+        return EntityState::INACTIVE;
+    }
     return m_entity_states[entity_id];
 }
 
-char* EntityManager::GetEntityTag(uint32_t entity_id)
+const char* EntityManager::GetEntityTag(uint32_t entity_id)
+{
+    if(entity_id >= m_num_entities)
+    {
+        return m_tag_names; // the empty tag
+    }
+    return &m_tag_names[m_entity_tag_ids[entity_id] * tag_length];
+}
+
+uint32_t EntityManager::GetTagId(const char* tag)
 {
-    return m_entity_tags[entity_id];
+    // Callers cache the id, so the tag is never released
+    uint32_t tag_id = InternTag(tag);
+    if(tag_id != invalid_tag_id)
+    {
+        m_tag_pinned[tag_id] = true;
+    }
+    return tag_id;
 }
 
-uint32_t EntityManager::GetEntityId(char* entity_tag)
+uint32_t EntityManager::GetEntityTagId(uint32_t entity_id)
 {
-    uint32_t entity_id = 0;
+    if(entity_id >= m_num_entities)
+    {
+        return invalid_tag_id;
+    }
+    return m_entity_tag_ids[entity_id];
+}
+
+uint32_t EntityManager::GetEntityId(const char* entity_tag)
+{
+    return GetEntityId(FindTag(entity_tag, HashTag(entity_tag)));
+}
+
+uint32_t EntityManager::GetEntityId(uint32_t tag_id)
+{
+    if(tag_id >= m_num_tags)
+    {
+        return invalid_entity_id;
+    }
+    return m_tag_entities[tag_id];
+}
+
+uint32_t EntityManager::InternTag(const char* tag)
+{
+    uint32_t hash = HashTag(tag);
+    uint32_t tag_id = FindTag(tag, hash);
+    if(tag_id != invalid_tag_id)
+    {
+        return tag_id;
+    }
+
+    if(m_num_free_tags > 0)
+    {
+        tag_id = m_free_tags[--m_num_free_tags];
+    }
+    else
+    {
+        if(m_num_tags >= m_max_num_tags)
+        {
+            GrowTags(m_max_num_tags * 2);
+        }
+        tag_id = m_num_tags++;
+    }
+
+    char* tag_name = &m_tag_names[tag_id * tag_length];
+    strncpy(tag_name, tag, tag_length);
+    tag_name[tag_length - 1] = '\0';
+    m_tag_hashes[tag_id] = hash;
+    m_tag_entities[tag_id] = invalid_entity_id;
+    m_tag_pinned[tag_id] = false;
+    InsertTag(tag_id);
+
+    return tag_id;
+}
+
+void EntityManager::InsertTag(uint32_t tag_id)
+{
+    uint32_t slot = m_tag_hashes[tag_id] & m_tag_table_mask;
+    while(m_tag_table[slot] != 0)
+    {
+        slot = (slot + 1) & m_tag_table_mask;
+    }
+    m_tag_table[slot] = tag_id + 1;
+}
+
+// Frees a tag nobody can still refer to: no entity holds it and its id was
+// never handed out by GetTagId
+void EntityManager::ReleaseTag(uint32_t tag_id)
+{
+    if(m_tag_pinned[tag_id] || m_tag_entities[tag_id] != invalid_entity_id)
+    {
+        return;
+    }
+
+    uint32_t slot = m_tag_hashes[tag_id] & m_tag_table_mask;
+    while(m_tag_table[slot] != tag_id + 1)
+    {
+        slot = (slot + 1) & m_tag_table_mask;
+    }
+
+    // Shift later entries of the probe run back into the gap so lookups
+    // never stop early at it
+    uint32_t next_slot = (slot + 1) & m_tag_table_mask;
+    while(m_tag_table[next_slot] != 0)
+    {
+        uint32_t home_slot = m_tag_hashes[m_tag_table[next_slot] - 1] & m_tag_table_mask;
+        if(((next_slot - home_slot) & m_tag_table_mask) >= ((next_slot - slot) & m_tag_table_mask))
+        {
+            m_tag_table[slot] = m_tag_table[next_slot];
+            slot = next_slot;
+        }
+        next_slot = (next_slot + 1) & m_tag_table_mask;
+    }
+    m_tag_table[slot] = 0;
+
+    m_free_tags[m_num_free_tags++] = tag_id;
+}
+
+// Each tag keeps a doubly linked list of its holders through the entity
+// arrays, newest first, so adding or removing a holder is constant time.
+// The empty tag has no list.
+void EntityManager::LinkTagHolder(uint32_t entity_id)
+{
+    uint32_t tag_id = m_entity_tag_ids[entity_id];
+    if(tag_id == 0)
+    {
+        return;
+    }
+
+    uint32_t head = m_tag_entities[tag_id];
+    m_entity_tag_previous[entity_id] = invalid_entity_id;
+    m_entity_tag_next[entity_id] = head;
+    if(head != invalid_entity_id)
+    {
+        m_entity_tag_previous[head] = entity_id;
+    }
+    m_tag_entities[tag_id] = entity_id;
+}
+
+void EntityManager::UnlinkTagHolder(uint32_t entity_id)
+{
+    uint32_t tag_id = m_entity_tag_ids[entity_id];
+    if(tag_id == 0)
+    {
+        return;
+    }
+
+    uint32_t previous = m_entity_tag_previous[entity_id];
+    uint32_t next = m_entity_tag_next[entity_id];
+    if(previous != invalid_entity_id)
+    {
+        m_entity_tag_next[previous] = next;
+    }
+    else
+    {
+        m_tag_entities[tag_id] = next;
+    }
+    if(next != invalid_entity_id)
+    {
+        m_entity_tag_previous[next] = previous;
+    }
+}
+
+// Rebuilds the lookup table at the size that keeps its load factor down
+void EntityManager::GrowTags(uint32_t max_num_tags)
+{
+    char* tag_names = new char[max_num_tags * tag_length];
+    memcpy(tag_names, m_tag_names, m_num_tags * tag_length);
+    delete[] m_tag_names;
+    m_tag_names = tag_names;
+    GrowArray(m_tag_hashes, m_num_tags, max_num_tags);
+    GrowArray(m_tag_entities, m_num_tags, max_num_tags);
+    GrowArray(m_tag_pinned, m_num_tags, max_num_tags);
+    GrowArray(m_free_tags, m_num_free_tags, max_num_tags);
+    m_max_num_tags = max_num_tags;
+
+    uint32_t table_size = GetTagTableSize(max_num_tags);
+    delete[] m_tag_table;
+    m_tag_table = new uint32_t[table_size];
+    memset(m_tag_table, 0, table_size * sizeof(uint32_t));
+    m_tag_table_mask = table_size - 1;
+
+    // Free slots stay out of the table so they aren't found by name
+    bool* is_free = new bool[m_num_tags];
+    memset(is_free, 0, m_num_tags * sizeof(bool));
+    for(uint32_t i = 0; i < m_num_free_tags; i++)
+    {
+        is_free[m_free_tags[i]] = true;
+    }
+    for(uint32_t i = 0; i < m_num_tags; i++)
+    {
+        if(!is_free[i])
+        {
+            InsertTag(i);
+        }
+    }
+    delete[] is_free;
+}
+
+uint32_t EntityManager::FindTag(const char* tag, uint32_t hash)
+{
+    uint32_t slot = hash & m_tag_table_mask;
+    while(m_tag_table[slot] != 0)
+    {
+        uint32_t tag_id = m_tag_table[slot] - 1;
+        if(m_tag_hashes[tag_id] == hash && strncmp(&m_tag_names[tag_id * tag_length], tag, tag_length - 1) == 0)
+        {
+            return tag_id;
+        }
+        slot = (slot + 1) & m_tag_table_mask;
+    }
+    return invalid_tag_id;
+}
+
+uint32_t EntityManager::RegisterQuery(uint32_t signature)
+{
+    for(uint32_t i = 0; i < m_num_queries; i++)
+    {
+        if(m_query_signatures[i] == signature)
+        {
+            return i;
+        }
+    }
+
+    if(m_num_queries >= max_num_queries)
+    {
+        printf("TOO MANY QUERIES\n");
+        return invalid_query_id;
+    }
+
+    uint32_t query_id = m_num_queries++;
+    m_query_signatures[query_id] = signature;
+    m_query_sizes[query_id] = 0;
+    m_query_entities[query_id] = new uint32_t[m_num_entities];
+    m_query_positions[query_id] = new uint32_t[m_num_entities];
+
+    // Entities are usually created before systems register, so populate now
     for(uint32_t i = 0; i < m_num_entities; i++)
     {
-        if(strcmp(m_entity_tags[i], entity_tag) == 0)
+        UpdateQueries(i);
+    }
+
+    return query_id;
+}
+
+uint32_t EntityManager::GetQuerySize(uint32_t query_id)
+{
+    if(query_id >= m_num_queries)
+    {
+        return 0;
+    }
+    return m_query_sizes[query_id];
+}
+
+uint32_t* EntityManager::GetQueryEntities(uint32_t query_id)
+{
+    if(query_id >= m_num_queries)
+    {
+        return NULL;
+    }
+    return m_query_entities[query_id];
+}
+
+void EntityManager::UpdateQueries(uint32_t entity_id)
+{
+    bool is_active = m_entity_states[entity_id] == EntityState::ACTIVE;
+
+    for(uint32_t i = 0; i < m_num_queries; i++)
+    {
+        uint32_t query_bit = 1u << i;
+        bool is_match = is_active && (m_entity_signatures[entity_id] & m_query_signatures[i]);
+        bool is_member = m_query_membership[entity_id] & query_bit;
+        if(is_match == is_member)
+        {
+            continue;
+        }
+
+        // Members are kept unordered so both cases are constant time
+        uint32_t* entities = m_query_entities[i];
+        uint32_t* positions = m_query_positions[i];
+        if(is_match)
+        {
+            positions[entity_id] = m_query_sizes[i];
+            entities[m_query_sizes[i]++] = entity_id;
+            m_query_membership[entity_id] |= query_bit;
+        }
+        else
         {
-            entity_id = i;
+            // Move the last member into the gap
+            uint32_t position = positions[entity_id];
+            uint32_t last_entity_id = entities[--m_query_sizes[i]];
+            entities[position] = last_entity_id;
+            positions[last_entity_id] = position;
+            m_query_membership[entity_id] &= ~query_bit;
         }
     }
-    return entity_id;
+}
+
+void EntityManager::Grow(uint32_t num_entities)
+{
+    GrowArray(m_entity_signatures, m_num_entities, num_entities);
+    GrowArray(m_entity_states, m_num_entities, num_entities);
+    GrowArray(m_entity_generations, m_num_entities, num_entities);
+    GrowArray(m_entity_alive, m_num_entities, num_entities);
+    GrowArray(m_free_entities, m_num_free_entities, num_entities);
+    GrowArray(m_query_membership, m_num_entities, num_entities);
+    GrowArray(m_entity_tag_ids, m_num_entities, num_entities);
+    GrowArray(m_entity_tag_next, m_num_entities, num_entities);
+    GrowArray(m_entity_tag_previous, m_num_entities, num_entities);
+    for(uint32_t i = 0; i < m_num_queries; i++)
+    {
+        GrowArray(m_query_entities[i], m_query_sizes[i], num_entities);
+        GrowArray(m_query_positions[i], m_num_entities, num_entities);
+    }
+    m_num_entities = num_entities;
+
+    // Every entity can hold a distinct tag, with room left for pinned ones
+    if(m_max_num_tags < num_entities * 2)
+    {
+        GrowTags(num_entities * 2);
+    }
 }
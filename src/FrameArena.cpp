@@ -0,0 +1,80 @@
+#include "FrameArena.hpp"
+
+static void* AlignPointer(char* memory, uint32_t alignment)
+{
+    uintptr_t address = (uintptr_t)memory;
+    address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    return (void*)address;
+}
+
+FrameArena::FrameArena(uint32_t capacity) :
+    m_capacity(capacity),
+    m_memory(new char[capacity]),
+    m_offset(0),
+    m_num_spilled_bytes(0)
+{
+
+}
+
+FrameArena::~FrameArena()
+{
+    Reset();
+    delete[] m_memory;
+}
+
+void* FrameArena::Allocate(uint32_t size, uint32_t alignment, bool allow_spill)
+{
+    // Reserve enough to align inside the range without a CAS loop
+    uint32_t reserve_size = size + alignment - 1;
+    uint32_t offset = m_offset.fetch_add(reserve_size, std::memory_order_relaxed);
+    if(offset + reserve_size <= m_capacity && offset + reserve_size >= offset)
+    {
+        return AlignPointer(m_memory + offset, alignment);
+    }
+
+    if(!allow_spill)
+    {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_spill_mutex);
+    char* block = new char[reserve_size];
+    m_spilled_blocks.push_back(block);
+    m_num_spilled_bytes += reserve_size;
+    return AlignPointer(block, alignment);
+}
+
+void FrameArena::Reset()
+{
+    for(uint32_t i = 0; i < m_spilled_blocks.size(); i++)
+    {
+        delete[] m_spilled_blocks[i];
+    }
+    m_spilled_blocks.clear();
+
+    // Size the arena so a frame like this one fits without spilling
+    if(m_num_spilled_bytes > 0)
+    {
+        uint32_t capacity = m_capacity > 0 ? m_capacity : 1;
+        while(capacity < m_capacity + m_num_spilled_bytes)
+        {
+            capacity *= 2;
+        }
+        delete[] m_memory;
+        m_memory = new char[capacity];
+        m_capacity = capacity;
+        m_num_spilled_bytes = 0;
+    }
+
+    m_offset.store(0, std::memory_order_relaxed);
+}
+
+uint32_t FrameArena::GetCapacity()
+{
+    return m_capacity;
+}
+
+uint32_t FrameArena::GetNumSpilledBytes()
+{
+    return m_num_spilled_bytes;
+}
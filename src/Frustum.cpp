@@ -0,0 +1,81 @@
+#include <cmath>
+
+#include "Frustum.hpp"
+
+Frustum::Frustum()
+{
+    // Accepts everything until built
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        m_planes[i][0] = 0;
+        m_planes[i][1] = 0;
+        m_planes[i][2] = 0;
+        m_planes[i][3] = 1;
+    }
+}
+
+Frustum::~Frustum()
+{
+
+}
+
+// Clip space keeps -w <= x, y, z <= w, so each plane is the fourth row of
+// the matrix plus or minus one of the others. linmath stores columns, so
+// row i is m[0][i], m[1][i], m[2][i], m[3][i].
+void Frustum::Build(mat4x4 view_projection_matrix)
+{
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        uint32_t row = i / 2;
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+        for(uint32_t j = 0; j < 4; j++)
+        {
+            m_planes[i][j] = view_projection_matrix[j][3] + sign * view_projection_matrix[j][row];
+        }
+
+        float length = sqrtf(m_planes[i][0] * m_planes[i][0] +
+                             m_planes[i][1] * m_planes[i][1] +
+                             m_planes[i][2] * m_planes[i][2]);
+        if(length > 0)
+        {
+            m_planes[i][0] /= length;
+            m_planes[i][1] /= length;
+            m_planes[i][2] /= length;
+            m_planes[i][3] /= length;
+        }
+    }
+}
+
+bool Frustum::IntersectsSphere(const vec3 center, float radius)
+{
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        float distance = m_planes[i][0] * center[0] +
+                         m_planes[i][1] * center[1] +
+                         m_planes[i][2] * center[2] +
+                         m_planes[i][3];
+        if(distance < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Only the box corner furthest along each plane normal needs testing
+bool Frustum::IntersectsBox(const vec3 min, const vec3 max)
+{
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        float distance = m_planes[i][3];
+        for(uint32_t j = 0; j < 3; j++)
+        {
+            distance += m_planes[i][j] * (m_planes[i][j] > 0 ? max[j] : min[j]);
+        }
+        if(distance < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,167 @@
+#include "JobSystem.hpp"
+
+namespace
+{
+    // Worker index of the calling thread, threads the job system did not
+    // create submit through the queue of worker 0
+    thread_local uint32_t current_worker_index = 0;
+}
+
+JobSystem::JobSystem(uint32_t num_threads) :
+    m_num_threads(num_threads > 0 ? num_threads : 1),
+    m_queues(new WorkerQueue[m_num_threads]),
+    m_threads(new std::thread[m_num_threads]),
+    m_num_queued_jobs(0),
+    m_running(true)
+{
+    for(uint32_t i = 1; i < m_num_threads; i++)
+    {
+        m_threads[i] = std::thread(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_running = false;
+    }
+    m_sleep_condition.notify_all();
+
+    for(uint32_t i = 1; i < m_num_threads; i++)
+    {
+        m_threads[i].join();
+    }
+
+    delete[] m_threads;
+    delete[] m_queues;
+}
+
+void JobSystem::Submit(JobFunction function, void* data, uint32_t begin, uint32_t end, JobCounter& counter)
+{
+    Job job;
+    job.function = function;
+    job.data = data;
+    job.begin = begin;
+    job.end = end;
+    job.counter = &counter;
+
+    counter++;
+
+    // Count the job before it becomes visible so a thief can never take the
+    // queued count below zero
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_num_queued_jobs++;
+    }
+
+    WorkerQueue& queue = m_queues[GetWorkerIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+    m_sleep_condition.notify_one();
+}
+
+void JobSystem::SubmitRange(JobFunction function, void* data, uint32_t count, uint32_t chunk_size, JobCounter& counter)
+{
+    if(chunk_size == 0)
+    {
+        chunk_size = 1;
+    }
+
+    for(uint32_t begin = 0; begin < count; begin += chunk_size)
+    {
+        uint32_t end = begin + chunk_size < count ? begin + chunk_size : count;
+        Submit(function, data, begin, end, counter);
+    }
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    uint32_t worker_index = GetWorkerIndex();
+    while(counter > 0)
+    {
+        Job job;
+        if(PopJob(worker_index, job) || StealJob(worker_index, job))
+        {
+            RunJob(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+uint32_t JobSystem::GetNumThreads()
+{
+    return m_num_threads;
+}
+
+void JobSystem::WorkerLoop(uint32_t worker_index)
+{
+    current_worker_index = worker_index;
+
+    while(true)
+    {
+        Job job;
+        if(PopJob(worker_index, job) || StealJob(worker_index, job))
+        {
+            RunJob(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_sleep_condition.wait(lock, [this] { return m_num_queued_jobs > 0 || !m_running; });
+        if(!m_running)
+        {
+            return;
+        }
+    }
+}
+
+bool JobSystem::PopJob(uint32_t worker_index, Job& job)
+{
+    WorkerQueue& queue = m_queues[worker_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(queue.jobs.empty())
+    {
+        return false;
+    }
+
+    job = queue.jobs.back();
+    queue.jobs.pop_back();
+    m_num_queued_jobs--;
+    return true;
+}
+
+bool JobSystem::StealJob(uint32_t worker_index, Job& job)
+{
+    for(uint32_t i = 1; i < m_num_threads; i++)
+    {
+        WorkerQueue& queue = m_queues[(worker_index + i) % m_num_threads];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.jobs.empty())
+        {
+            continue;
+        }
+
+        job = queue.jobs.front();
+        queue.jobs.pop_front();
+        m_num_queued_jobs--;
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::RunJob(Job& job)
+{
+    job.function(job.data, job.begin, job.end);
+    (*job.counter)--;
+}
+
+uint32_t JobSystem::GetWorkerIndex()
+{
+    return current_worker_index < m_num_threads ? current_worker_index : 0;
+}
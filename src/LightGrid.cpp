@@ -0,0 +1,284 @@
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#include "LightGrid.hpp"
+
+// Enough to take any positive cell size past the widest finite extent
+const uint32_t max_cell_size_doublings = 256;
+
+// Cell holding a coordinate along one axis, clamped to the grid. Done in
+// double first so far away coordinates can't overflow the integer cast.
+static int32_t GetClampedCell(double coordinate, float cell_size, int32_t dimension)
+{
+    double cell = floor(coordinate / cell_size);
+    if(!(cell >= 0))
+    {
+        return 0;
+    }
+    if(cell >= dimension - 1)
+    {
+        return dimension - 1;
+    }
+    return (int32_t)cell;
+}
+
+LightGrid::LightGrid(float cell_size, uint32_t max_cells) :
+    m_base_cell_size(cell_size),
+    m_max_cells(max_cells),
+    m_cell_size(cell_size)
+{
+    Clear();
+}
+
+LightGrid::~LightGrid()
+{
+
+}
+
+void LightGrid::Clear()
+{
+    m_lights.clear();
+    m_cell_ranges.clear();
+    m_light_indices.clear();
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        m_origin[i] = 0;
+        m_dimensions[i] = 0;
+    }
+}
+
+void LightGrid::AddLight(const vec3 position, float radius, const vec3 color)
+{
+    // A light without finite bounds would make the grid infinitely large
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        if(!std::isfinite(position[i] - radius) || !std::isfinite(position[i] + radius) || !(radius >= 0))
+        {
+            printf("Ignoring light with invalid bounds\n");
+            return;
+        }
+    }
+
+    GridLight light;
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        light.position[i] = position[i];
+        light.color[i] = color[i];
+    }
+    light.radius = radius;
+    light.padding = 0;
+    m_lights.push_back(light);
+}
+
+// Two passes over the lights, counting and then filling, so the index list
+// is packed per cell
+void LightGrid::Build()
+{
+    m_cell_ranges.clear();
+    m_light_indices.clear();
+    if(m_lights.empty())
+    {
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            m_dimensions[i] = 0;
+        }
+        return;
+    }
+
+    vec3 min;
+    vec3 max;
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        min[i] = m_lights[0].position[i] - m_lights[0].radius;
+        max[i] = m_lights[0].position[i] + m_lights[0].radius;
+    }
+    for(uint32_t i = 1; i < m_lights.size(); i++)
+    {
+        for(uint32_t j = 0; j < 3; j++)
+        {
+            min[j] = std::min(min[j], m_lights[i].position[j] - m_lights[i].radius);
+            max[j] = std::max(max[j], m_lights[i].position[j] + m_lights[i].radius);
+        }
+    }
+
+    // Counted in double since the extent of finite bounds can still
+    // overflow a float or the cell count an integer
+    double extent[3];
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        extent[i] = (double)max[i] - min[i];
+        m_origin[i] = min[i];
+    }
+    m_cell_size = m_base_cell_size;
+    bool fits = false;
+    for(uint32_t doubling = 0; doubling < max_cell_size_doublings && !fits; doubling++)
+    {
+        double num_cells = 1;
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            num_cells *= std::max(1.0, ceil(extent[i] / m_cell_size));
+        }
+        fits = num_cells <= m_max_cells;
+        if(!fits)
+        {
+            m_cell_size *= 2;
+        }
+    }
+    if(fits)
+    {
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            m_dimensions[i] = std::max(1.0, ceil(extent[i] / m_cell_size));
+        }
+    }
+    else
+    {
+        // The cell size can't grow far enough, so fall back to one cell
+        // that holds every light
+        m_cell_size = std::max(m_base_cell_size, (float)std::min((double)FLT_MAX,
+                               std::max(extent[0], std::max(extent[1], extent[2]))));
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            m_dimensions[i] = 1;
+        }
+    }
+
+    uint32_t num_cells = m_dimensions[0] * m_dimensions[1] * m_dimensions[2];
+    m_cell_ranges.resize(num_cells);
+    for(uint32_t i = 0; i < num_cells; i++)
+    {
+        m_cell_ranges[i].first_index = 0;
+        m_cell_ranges[i].num_lights = 0;
+    }
+
+    for(uint32_t pass = 0; pass < 2; pass++)
+    {
+        for(uint32_t i = 0; i < m_lights.size(); i++)
+        {
+            const GridLight& light = m_lights[i];
+
+            int32_t first_cell[3];
+            int32_t last_cell[3];
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                first_cell[j] = GetClampedCell((double)light.position[j] - light.radius - m_origin[j], m_cell_size, m_dimensions[j]);
+                last_cell[j] = GetClampedCell((double)light.position[j] + light.radius - m_origin[j], m_cell_size, m_dimensions[j]);
+            }
+
+            for(int32_t z = first_cell[2]; z <= last_cell[2]; z++)
+            {
+                for(int32_t y = first_cell[1]; y <= last_cell[1]; y++)
+                {
+                    for(int32_t x = first_cell[0]; x <= last_cell[0]; x++)
+                    {
+                        // Skip cells the box of the sphere touches but the
+                        // sphere itself misses
+                        int32_t cell[3] = { x, y, z };
+                        float distance_squared = 0;
+                        for(uint32_t j = 0; j < 3; j++)
+                        {
+                            float cell_min = m_origin[j] + cell[j] * m_cell_size;
+                            float closest = std::max(cell_min, std::min(light.position[j], cell_min + m_cell_size));
+                            distance_squared += (light.position[j] - closest) * (light.position[j] - closest);
+                        }
+                        if(distance_squared > light.radius * light.radius)
+                        {
+                            continue;
+                        }
+
+                        LightCellRange& range = m_cell_ranges[(z * m_dimensions[1] + y) * m_dimensions[0] + x];
+                        if(pass == 0)
+                        {
+                            range.first_index++;
+                        }
+                        else
+                        {
+                            m_light_indices[range.first_index + range.num_lights] = i;
+                            range.num_lights++;
+                        }
+                    }
+                }
+            }
+        }
+
+        if(pass == 0)
+        {
+            // Turn the counts into offsets
+            uint32_t num_indices = 0;
+            for(uint32_t i = 0; i < num_cells; i++)
+            {
+                uint32_t count = m_cell_ranges[i].first_index;
+                m_cell_ranges[i].first_index = num_indices;
+                num_indices += count;
+            }
+            m_light_indices.resize(num_indices);
+        }
+    }
+}
+
+uint32_t LightGrid::GetNumLights()
+{
+    return m_lights.size();
+}
+
+const GridLight* LightGrid::GetLights()
+{
+    return m_lights.empty() ? NULL : &m_lights[0];
+}
+
+uint32_t LightGrid::GetNumCells()
+{
+    return m_cell_ranges.size();
+}
+
+const LightCellRange* LightGrid::GetCellRanges()
+{
+    return m_cell_ranges.empty() ? NULL : &m_cell_ranges[0];
+}
+
+uint32_t LightGrid::GetNumLightIndices()
+{
+    return m_light_indices.size();
+}
+
+const uint32_t* LightGrid::GetLightIndices()
+{
+    return m_light_indices.empty() ? NULL : &m_light_indices[0];
+}
+
+const float* LightGrid::GetOrigin()
+{
+    return m_origin;
+}
+
+float LightGrid::GetCellSize()
+{
+    return m_cell_size;
+}
+
+const int32_t* LightGrid::GetDimensions()
+{
+    return m_dimensions;
+}
+
+LightCellRange LightGrid::GetCellRange(const vec3 position)
+{
+    LightCellRange range;
+    range.first_index = 0;
+    range.num_lights = 0;
+
+    int32_t cell[3];
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        double coordinate = floor(((double)position[i] - m_origin[i]) / m_cell_size);
+        if(!(coordinate >= 0 && coordinate < m_dimensions[i]))
+        {
+            return range;
+        }
+        cell[i] = coordinate;
+    }
+
+    return m_cell_ranges[(cell[2] * m_dimensions[1] + cell[1]) * m_dimensions[0] + cell[0]];
+}
@@ -0,0 +1,137 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.hpp"
+
+MappedFile::MappedFile() :
+    m_data(NULL),
+    m_size(0)
+#ifdef _WIN32
+    , m_file(INVALID_HANDLE_VALUE),
+    m_mapping(NULL)
+#endif
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char* path)
+{
+    Close();
+
+    m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(m_file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(m_mapping == NULL)
+    {
+        Close();
+        return false;
+    }
+
+    m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if(m_data == NULL)
+    {
+        Close();
+        return false;
+    }
+    m_size = size.QuadPart;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(m_data != NULL)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if(m_mapping != NULL)
+    {
+        CloseHandle(m_mapping);
+    }
+    if(m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+    }
+    m_data = NULL;
+    m_size = 0;
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::Open(const char* path)
+{
+    Close();
+
+    int file = open(path, O_RDONLY);
+    if(file < 0)
+    {
+        return false;
+    }
+
+    struct stat file_stat;
+    if(fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if(data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_data = (const unsigned char*)data;
+    m_size = file_stat.st_size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(m_data != NULL)
+    {
+        munmap((void*)m_data, m_size);
+    }
+    m_data = NULL;
+    m_size = 0;
+}
+
+#endif
+
+const unsigned char* MappedFile::GetData()
+{
+    return m_data;
+}
+
+size_t MappedFile::GetSize()
+{
+    return m_size;
+}
@@ -2,64 +2,241 @@
 
 #include "MessageBus.hpp"
 
-MessageBus::MessageBus(uint32_t max_num_messages, uint32_t max_num_systems) : 
-    m_max_num_messages(max_num_messages),
-    m_num_messages(0),
-    m_message_queue_index(0),
-    m_message_queue(new Message[max_num_messages]),
-    m_max_num_systems(max_num_systems),
-    m_num_systems(0),
-    m_systems(new System*[max_num_systems])
+static uint32_t RoundUpToPowerOfTwo(uint32_t value)
 {
+    uint32_t result = 1;
+    while(result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
 
+MessageBus::MessageBus(uint32_t max_num_messages, uint32_t max_num_systems, MessageOverflowPolicy overflow_policy,
+                       uint32_t payload_arena_size) : 
+    m_overflow_policy(overflow_policy),
+    m_capacity(0),
+    m_mask(0),
+    m_slots(0),
+    m_tail(0),
+    m_head(0),
+    m_num_dropped_messages(0),
+    m_consumer_thread(std::this_thread::get_id()),
+    m_payload_arenas{ { payload_arena_size }, { payload_arena_size } },
+    m_payload_arena_index(0),
+    m_max_num_systems(max_num_systems)
+{
+    for(uint32_t i = 0; i < NUM_MESSAGE_TYPES; i++)
+    {
+        m_num_subscribers[i] = 0;
+        m_subscribers[i] = new System*[max_num_systems];
+    }
+    Resize(max_num_messages);
 }
 
 MessageBus::~MessageBus()
 {
-    delete[] m_message_queue;
+    delete[] m_slots;
+    for(uint32_t i = 0; i < NUM_MESSAGE_TYPES; i++)
+    {
+        delete[] m_subscribers[i];
+    }
 }
 
-void MessageBus::RegisterSystem(System* system)
+void MessageBus::Subscribe(System* system, MessageType message_type)
 {
-    if(m_num_systems < m_max_num_systems)
+    uint32_t& num_subscribers = m_num_subscribers[message_type];
+    System** subscribers = m_subscribers[message_type];
+    for(uint32_t i = 0; i < num_subscribers; i++)
+    {
+        if(subscribers[i] == system)
+        {
+            return;
+        }
+    }
+    if(num_subscribers < m_max_num_systems)
     {
-        m_systems[m_num_systems++] = system;
+        subscribers[num_subscribers++] = system;
     }
 }
 
 void MessageBus::Update()
 {
-    // Rewind the circular queue? TODO: make this better
-    uint32_t message_queue_index = m_message_queue_index;
-    for(uint32_t i = 0; i < m_num_messages; i++)
+    m_consumer_thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+    // Everything queued so far has its payload in the current arena
+    uint32_t payload_arena_index = m_payload_arena_index.load(std::memory_order_relaxed);
+    m_payload_arena_index.store(payload_arena_index ^ 1, std::memory_order_relaxed);
+
+    // Messages posted by the handlers below wait for the next Update
+    uint32_t messages_to_read = m_tail.load(std::memory_order_acquire) - m_head;
+    {
+        std::lock_guard<std::mutex> lock(m_overflow_mutex);
+        m_pending_overflow_messages.swap(m_overflow_messages);
+    }
+
+    Message message;
+    for(uint32_t i = 0; i < messages_to_read && TryPop(message); i++)
+    {
+        Dispatch(message);
+    }
+
+    // Overflow was posted while the ring was full, so it comes after everything in it
+    for(uint32_t i = 0; i < m_pending_overflow_messages.size(); i++)
+    {
+        Dispatch(m_pending_overflow_messages[i]);
+    }
+
+    if(!m_pending_overflow_messages.empty() && m_overflow_policy == MESSAGE_OVERFLOW_GROW)
+    {
+        Resize(m_capacity + m_pending_overflow_messages.size());
+    }
+    m_pending_overflow_messages.clear();
+    m_payload_arenas[payload_arena_index].Reset();
+}
+
+void MessageBus::PostMessage(Message message)
+{
+    if(TryPush(message))
+    {
+        return;
+    }
+
+    MessageOverflowPolicy overflow_policy = m_overflow_policy;
+    // Update can't drain the ring on the thread that is posting, whether
+    // from a handler or from anything else that thread runs between Updates
+    if(overflow_policy == MESSAGE_OVERFLOW_BLOCK && std::this_thread::get_id() == m_consumer_thread.load(std::memory_order_relaxed))
     {
-        message_queue_index--;
-        if(message_queue_index >= m_max_num_messages) message_queue_index = m_max_num_messages - 1; // Rollover occured
+        overflow_policy = MESSAGE_OVERFLOW_GROW;
     }
 
-    uint32_t messages_to_read = m_num_messages;
-    for(uint32_t i = 0; i < messages_to_read; i++)
+    switch(overflow_policy)
     {
-        for(uint32_t j = 0; j < m_num_systems; j++)
+        case MESSAGE_OVERFLOW_BLOCK:
+            while(!TryPush(message))
+            {
+                std::this_thread::yield();
+            }
+            break;
+        case MESSAGE_OVERFLOW_GROW:
         {
-            m_systems[j]->HandleMessage(m_message_queue[message_queue_index]);
+            std::lock_guard<std::mutex> lock(m_overflow_mutex);
+            m_overflow_messages.push_back(message);
+            break;
         }
-        message_queue_index++;
-        if(m_message_queue_index >= m_max_num_messages) m_message_queue_index = 0;
+        case MESSAGE_OVERFLOW_DROP:
+        default:
+            m_num_dropped_messages.fetch_add(1, std::memory_order_relaxed);
+            break;
     }
-    m_num_messages = m_num_messages - messages_to_read;
 }
 
-void MessageBus::PostMessage(Message message)
+void MessageBus::Dispatch(const Message& message)
 {
-    if(m_num_messages < m_max_num_messages)
+    if(message.message_type >= NUM_MESSAGE_TYPES)
     {
-        m_message_queue[m_message_queue_index++] = message;
-        if(m_message_queue_index >= m_max_num_messages) m_message_queue_index = 0;
-        m_num_messages++;
+        return;
     }
-    else
+    uint32_t num_subscribers = m_num_subscribers[message.message_type];
+    System** subscribers = m_subscribers[message.message_type];
+    for(uint32_t i = 0; i < num_subscribers; i++)
     {
-        printf("TOO MANY MESSAGES\n");
+        subscribers[i]->HandleMessage(message);
     }
 }
+
+void* MessageBus::AllocatePayload(uint32_t size, uint32_t alignment)
+{
+    FrameArena& payload_arena = m_payload_arenas[m_payload_arena_index.load(std::memory_order_relaxed)];
+    void* payload = payload_arena.Allocate(size, alignment, m_overflow_policy != MESSAGE_OVERFLOW_DROP);
+    if(payload == 0)
+    {
+        m_num_dropped_messages.fetch_add(1, std::memory_order_relaxed);
+    }
+    return payload;
+}
+
+uint32_t MessageBus::GetCapacity()
+{
+    return m_capacity;
+}
+
+uint32_t MessageBus::GetNumDroppedMessages()
+{
+    return m_num_dropped_messages.load(std::memory_order_relaxed);
+}
+
+bool MessageBus::TryPush(const Message& message)
+{
+    uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    while(true)
+    {
+        Slot& slot = m_slots[tail & m_mask];
+        uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        int32_t difference = (int32_t)(sequence - tail);
+        if(difference == 0)
+        {
+            // Claim the slot, then publish it once the message is written
+            if(m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+            {
+                slot.message = message;
+                slot.sequence.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if(difference < 0)
+        {
+            // The consumer hasn't freed this slot yet so the ring is full
+            return false;
+        }
+        else
+        {
+            tail = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool MessageBus::TryPop(Message& message)
+{
+    Slot& slot = m_slots[m_head & m_mask];
+    uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if(sequence != m_head + 1)
+    {
+        // Claimed but not written yet
+        return false;
+    }
+    message = slot.message;
+    slot.sequence.store(m_head + m_capacity, std::memory_order_release);
+    m_head++;
+    return true;
+}
+
+void MessageBus::Resize(uint32_t capacity)
+{
+    capacity = RoundUpToPowerOfTwo(capacity);
+    if(capacity <= m_capacity)
+    {
+        return;
+    }
+
+    Slot* slots = new Slot[capacity];
+    uint32_t num_messages = 0;
+    Message message;
+    while(m_slots != 0 && TryPop(message))
+    {
+        slots[num_messages].message = message;
+        slots[num_messages].sequence.store(num_messages + 1, std::memory_order_relaxed);
+        num_messages++;
+    }
+    for(uint32_t i = num_messages; i < capacity; i++)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    delete[] m_slots;
+    m_slots = slots;
+    m_capacity = capacity;
+    m_mask = capacity - 1;
+    m_head = 0;
+    m_tail.store(num_messages, std::memory_order_release);
+}
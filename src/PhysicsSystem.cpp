@@ -34,15 +34,211 @@ void GetEntryExit(float v, float inv_entry, float inv_exit, float& entry, float&
 }
 
 
+const float broadphase_cell_size = 2.0f;
+
 PhysicsSystem::PhysicsSystem(MessageBus& message_bus) : 
-    System(message_bus, PHYSICS_SYSTEM_SIGNATURE)
+    System(message_bus, PHYSICS_SYSTEM_SIGNATURE),
+    m_collision_query_id(invalid_query_id),
+    m_broadphase(NULL)
 {
-
+    DeclareAccess(BOUNDING_BOX_ACCESS | COLLISION_LAYER_ACCESS | ENTITY_STATE_ACCESS,
+                  TRANSFORM_ACCESS | RIGID_BODY_ACCESS | MODEL_MATRIX_ACCESS,
+                  false);
 }
 
 PhysicsSystem::~PhysicsSystem()
 {
+    delete m_broadphase;
+}
+
+void PhysicsSystem::SetEntityManager(EntityManager* entity_manager)
+{
+    System::SetEntityManager(entity_manager);
+    m_collision_query_id = m_entity_manager->RegisterQuery(COLLISION_SYSTEM_SIGNATURE);
+
+    delete m_broadphase;
+    m_broadphase = new SpatialHash(m_entity_manager->GetNumEntities(), broadphase_cell_size);
+}
+
+// Bake every static collider into the BVH. Call once the level is loaded;
+// colliders marked static afterwards are not seen until this runs again.
+void PhysicsSystem::BuildStaticColliders()
+{
+    m_static_colliders.Clear();
+
+    uint32_t num_colliders = m_entity_manager->GetQuerySize(m_collision_query_id);
+    uint32_t* colliders = m_entity_manager->GetQueryEntities(m_collision_query_id);
+    for(uint32_t i = 0; i < num_colliders; i++)
+    {
+        uint32_t entity_id = colliders[i];
+        if(!(m_entity_manager->GetEntitySignature(entity_id) & STATIC_SIGNATURE))
+        {
+            continue;
+        }
+
+        vec3 min;
+        vec3 max;
+        GetColliderBounds(entity_id, min, max);
+        m_static_colliders.Insert(entity_id, min, max);
+    }
+
+    m_static_colliders.Build();
+}
+
+// Bodies with colliders go through HandleEntity one at a time. Those that
+// end the sweep without a hit, and bodies without colliders, are integrated
+// afterwards in one batch over structure of arrays streams.
+void PhysicsSystem::Update(float delta_time)
+{
+    BuildBroadphase(delta_time);
+    m_body_streams.Clear();
+    m_contacts.Clear();
+
+    uint32_t num_entities = m_entity_manager->GetQuerySize(m_query_id);
+    uint32_t* entities = m_entity_manager->GetQueryEntities(m_query_id);
+    for(uint32_t i = 0; i < num_entities; i++)
+    {
+        uint32_t entity_id = entities[i];
+        RigidBody& rigid_body = m_component_manager->GetComponent<RigidBody>(entity_id);
+        Transform& transform = m_component_manager->GetComponent<Transform>(entity_id);
+        rigid_body.previous_position[0] = transform.position[0];
+        rigid_body.previous_position[1] = transform.position[1];
+        rigid_body.previous_position[2] = transform.position[2];
+
+        if(m_entity_manager->GetEntitySignature(entity_id) & COLLISION_SYSTEM_SIGNATURE)
+        {
+            HandleEntity(entity_id, delta_time);
+        }
+        else
+        {
+            m_body_streams.AddBody(entity_id, transform.position, rigid_body.velocity, rigid_body.acceleration);
+        }
+    }
+
+    m_body_streams.Integrate(delta_time);
+
+    uint32_t num_bodies = m_body_streams.GetNumBodies();
+    for(uint32_t i = 0; i < num_bodies; i++)
+    {
+        uint32_t entity_id = m_body_streams.GetEntityId(i);
+        m_body_streams.GetPosition(i, m_component_manager->GetComponent<Transform>(entity_id).position);
+        m_body_streams.GetVelocity(i, m_component_manager->GetComponent<RigidBody>(entity_id).velocity);
+        MarkTransformChanged(entity_id);
+    }
+
+    PostContacts();
+}
+
+// Every contact of the step goes out as one COLLISION message
+void PhysicsSystem::PostContacts()
+{
+    uint32_t num_contacts = m_contacts.GetNumContacts();
+    if(num_contacts == 0)
+    {
+        return;
+    }
+
+    void* payload = m_message_bus.AllocatePayload(m_contacts.GetPayloadSize(), alignof(ContactStreamPayload));
+    if(payload == 0)
+    {
+        return;
+    }
+
+    Message message;
+    message.message_type = MessageType::COLLISION;
+    message.message_data = num_contacts;
+    message.payload = m_contacts.WritePayload(payload);
+    m_message_bus.PostMessage(message);
+}
+
+// Rebuild the grid of dynamic colliders once per step. Moving bodies are
+// inserted with the box they can sweep this step, so a query made after some
+// of them have already moved still finds them.
+void PhysicsSystem::BuildBroadphase(float delta_time)
+{
+    // Follow the entity manager when it grows
+    if(m_entity_manager->GetNumEntities() > m_broadphase->GetMaxNumItems())
+    {
+        delete m_broadphase;
+        m_broadphase = new SpatialHash(m_entity_manager->GetNumEntities(), broadphase_cell_size);
+    }
+    m_broadphase->Clear();
+
+    uint32_t num_colliders = m_entity_manager->GetQuerySize(m_collision_query_id);
+    uint32_t* colliders = m_entity_manager->GetQueryEntities(m_collision_query_id);
+    for(uint32_t i = 0; i < num_colliders; i++)
+    {
+        uint32_t entity_id = colliders[i];
+        uint32_t signature = m_entity_manager->GetEntitySignature(entity_id);
+        if(signature & STATIC_SIGNATURE)
+        {
+            continue;
+        }
+
+        vec3 min;
+        vec3 max;
+        GetColliderBounds(entity_id, min, max);
+
+        if(signature & PHYSICS_SYSTEM_SIGNATURE)
+        {
+            RigidBody& rigid_body = m_component_manager->GetComponent<RigidBody>(entity_id);
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                float displacement = (rigid_body.velocity[j] + rigid_body.acceleration[j]) * delta_time;
+                if(displacement > 0)
+                {
+                    max[j] += displacement;
+                }
+                else
+                {
+                    min[j] += displacement;
+                }
+            }
+        }
 
+        m_broadphase->Insert(entity_id, min, max);
+    }
+
+    m_broadphase->Build();
+}
+
+void PhysicsSystem::GetColliderBounds(uint32_t entity_id, vec3 min, vec3 max)
+{
+    Transform& transform = m_component_manager->GetComponent<Transform>(entity_id);
+    BoundingBox& bounding_box = m_component_manager->GetComponent<BoundingBox>(entity_id);
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        min[i] = transform.position[i] - bounding_box.extent[i] / 2;
+        max[i] = transform.position[i] + bounding_box.extent[i] / 2;
+    }
+}
+
+// Static candidates come with their baked bounds. Dynamic ones are read from
+// their current transform because they may have moved earlier in this step.
+void PhysicsSystem::GatherCandidates(const vec3 min, const vec3 max)
+{
+    m_candidates.clear();
+
+    uint32_t num_static = m_static_colliders.Query(min, max);
+    uint32_t* static_results = m_static_colliders.GetResults();
+    for(uint32_t i = 0; i < num_static; i++)
+    {
+        Collider collider;
+        collider.entity_id = m_static_colliders.GetItemId(static_results[i]);
+        const float* bounds = m_static_colliders.GetItemBounds(static_results[i]);
+        std::copy(bounds, bounds + 6, collider.bounds);
+        m_candidates.push_back(collider);
+    }
+
+    uint32_t num_dynamic = m_broadphase->Query(min, max);
+    uint32_t* dynamic_results = m_broadphase->GetCandidates();
+    for(uint32_t i = 0; i < num_dynamic; i++)
+    {
+        Collider collider;
+        collider.entity_id = dynamic_results[i];
+        GetColliderBounds(collider.entity_id, collider.bounds, collider.bounds + 3);
+        m_candidates.push_back(collider);
+    }
 }
 
 void PhysicsSystem::HandleMessage(Message message)
@@ -73,6 +269,7 @@ void PhysicsSystem::HandleEntity(uint32_t entity_id, float delta_time)
         float intended_z_position = transform.position[2] + rigid_body.velocity[2] * delta_time;
 
         BoundingBox& bounding_box = m_component_manager->GetComponent<BoundingBox>(entity_id);
+        CollisionLayer collision_layer = m_component_manager->GetComponent<CollisionLayer>(entity_id);
         float half_width = bounding_box.extent[0] / 2;
         float half_height = bounding_box.extent[1] / 2;
         float half_depth = bounding_box.extent[2] / 2;
@@ -113,22 +310,33 @@ void PhysicsSystem::HandleEntity(uint32_t entity_id, float delta_time)
             bp_max_z = rigid_body.velocity[2] > 0 ? intended_max_z : min_z;
         }
 
-        uint32_t num_entities = m_entity_manager->GetNumEntities();
-        for(uint32_t other_entity_id = 0; other_entity_id < num_entities; other_entity_id++)
+        vec3 bp_min = {bp_min_x, bp_min_y, bp_min_z};
+        vec3 bp_max = {bp_max_x, bp_max_y, bp_max_z};
+        GatherCandidates(bp_min, bp_max);
+
+        for(uint32_t i = 0; i < m_candidates.size(); i++)
         {
-            if(other_entity_id != entity_id && m_entity_manager->GetEntityState(other_entity_id) == EntityState::ACTIVE && m_entity_manager->GetEntitySignature(other_entity_id) & COLLISION_SYSTEM_SIGNATURE)
+            uint32_t other_entity_id = m_candidates[i].entity_id;
+            if(other_entity_id != entity_id && m_entity_manager->GetEntityState(other_entity_id) == EntityState::ACTIVE)
             {
-                BoundingBox& other_bounding_box = m_component_manager->GetComponent<BoundingBox>(other_entity_id);
-                Transform& other_transform = m_component_manager->GetComponent<Transform>(other_entity_id);
-                float other_half_width = other_bounding_box.extent[0] / 2;
-                float other_half_height = other_bounding_box.extent[1] / 2;
-                float other_half_depth = other_bounding_box.extent[2] / 2;
-                float other_min_x = other_transform.position[0] - other_half_width;
-                float other_max_x = other_transform.position[0] + other_half_width;
-                float other_min_y = other_transform.position[1] - other_half_height;
-                float other_max_y = other_transform.position[1] + other_half_height;
-                float other_min_z = other_transform.position[2] - other_half_depth;
-                float other_max_z = other_transform.position[2] + other_half_depth;
+                // Only layered entities collide, and the contact reads the layer again
+                if(!m_component_manager->HasComponent<CollisionLayer>(other_entity_id))
+                {
+                    continue;
+                }
+                uint32_t other_category = m_component_manager->GetComponent<CollisionLayer>(other_entity_id).category;
+                if(!(collision_layer.collides_with & other_category))
+                {
+                    continue;
+                }
+
+                const float* other_bounds = m_candidates[i].bounds;
+                float other_min_x = other_bounds[0];
+                float other_max_x = other_bounds[3];
+                float other_min_y = other_bounds[1];
+                float other_max_y = other_bounds[4];
+                float other_min_z = other_bounds[2];
+                float other_max_z = other_bounds[5];
 
                 bool collision_x = bp_max_x >= other_min_x && other_max_x >= bp_min_x;
                 bool collision_y = bp_max_y >= other_min_y && other_max_y >= bp_min_y;
@@ -207,29 +415,21 @@ void PhysicsSystem::HandleEntity(uint32_t entity_id, float delta_time)
         transform.position[0] += dotprod * normal[2];
         transform.position[1] += dotprod * normal[1];
         transform.position[2] += dotprod * normal[0];
+        MarkTransformChanged(entity_id);
         
-        char* entity_1_tag = m_entity_manager->GetEntityTag(entity_id);
-        char* entity_2_tag = m_entity_manager->GetEntityTag(collision_entity_id);
-        if(strcmp(entity_1_tag, "enemy") == 0 && strcmp(entity_2_tag, "side_wall") == 0)
-        {
-            Message message;
-            message.message_type = MessageType::COLLISION;
-            message.message_data = (entity_id << 16) + collision_entity_id;
-            m_message_bus.PostMessage(message);
-        }
-        
-        if(strncmp(entity_1_tag, "bullet", 6) == 0 && strcmp(entity_2_tag, "enemy") == 0)
+        uint32_t reports_to = m_component_manager->GetComponent<CollisionLayer>(entity_id).reports_to;
+        uint32_t other_category = m_component_manager->GetComponent<CollisionLayer>(collision_entity_id).category;
+        if(reports_to & other_category)
         {
-            Message message;
-            message.message_type = MessageType::COLLISION;
-            message.message_data = (entity_id << 16) + collision_entity_id;
-            m_message_bus.PostMessage(message);
+            // Handles, since either entity may be destroyed before delivery
+            m_contacts.AddContact(m_entity_manager->GetEntityHandle(entity_id), m_entity_manager->GetEntityHandle(collision_entity_id),
+                                  normal, move_time / delta_time);
         }
     }
     else
     {
-        transform.position[0] += rigid_body.velocity[0] * delta_time;
-        transform.position[1] += rigid_body.velocity[1] * delta_time;
-        transform.position[2] += rigid_body.velocity[2] * delta_time;
+        // Acceleration was already applied above
+        vec3 no_acceleration = {0, 0, 0};
+        m_body_streams.AddBody(entity_id, transform.position, rigid_body.velocity, no_acceleration);
     }
 }
\ No newline at end of file
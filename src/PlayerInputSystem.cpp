@@ -5,41 +5,81 @@
 #include "PlayerInputSystem.hpp"
 
 
+// Seconds before a bullet that hit nothing is destroyed
+const float bullet_lifetime = 2.0f;
+
 PlayerInputSystem::PlayerInputSystem(MessageBus& message_bus, InputMap& input_map) : 
     System(message_bus, PLAYER_INPUT_SYSTEM_SIGNATURE), 
     m_input_map(input_map),
     m_zoom_on(false),
     m_xray_on(false),
     m_shoot_timer(0),
-    m_num_bullets(32),
-    m_bullet_index(0)
+    m_player_tag_id(invalid_tag_id),
+    m_timer_tag_id(invalid_tag_id),
+    m_title_tag_id(invalid_tag_id),
+    m_win_tag_id(invalid_tag_id),
+    m_lose_tag_id(invalid_tag_id),
+    m_crosshair_tag_id(invalid_tag_id)
 {
-
+    // Spawning bullets writes every component a bullet carries
+    DeclareAccess(0,
+                  TRANSFORM_ACCESS | RIGID_BODY_ACCESS | PLAYER_INPUT_ACCESS | LABEL_ACCESS | MODEL_MATRIX_ACCESS | ENTITY_STATE_ACCESS |
+                  TEXTURE_ACCESS | QUAD_ACCESS | BOUNDING_BOX_ACCESS | COLLISION_LAYER_ACCESS,
+                  false);
+    Subscribe(COLLISION);
 }
 
 PlayerInputSystem::~PlayerInputSystem()
 {
 }
 
+void PlayerInputSystem::SetEntityManager(EntityManager* entity_manager)
+{
+    System::SetEntityManager(entity_manager);
+
+    m_player_tag_id = m_entity_manager->GetTagId("player");
+    m_timer_tag_id = m_entity_manager->GetTagId("timer_entity");
+    m_title_tag_id = m_entity_manager->GetTagId("title_entity");
+    m_win_tag_id = m_entity_manager->GetTagId("win_entity");
+    m_lose_tag_id = m_entity_manager->GetTagId("lose_entity");
+    m_crosshair_tag_id = m_entity_manager->GetTagId("crosshair");
+}
+
 void PlayerInputSystem::HandleMessage(Message message)
 {
     if(message.message_type == MessageType::COLLISION)
     {
-        uint32_t entity_1_id = message.message_data >> 16;
-        uint32_t entity_2_id = message.message_data & 0x0000FFFF;
+        const ContactStreamPayload* contacts = (const ContactStreamPayload*)message.payload;
+        // Resolved once for the whole step rather than per contact
+        uint32_t player_id = m_entity_manager->GetEntityId(m_player_tag_id);
 
-        char* entity_1_tag = m_entity_manager->GetEntityTag(entity_1_id);
-        char* entity_2_tag = m_entity_manager->GetEntityTag(entity_2_id);
-
-        if(strncmp(entity_1_tag, "bullet", 6) == 0)
+        for(uint32_t i = 0; i < contacts->num_contacts; i++)
         {
-            uint32_t bullet_id = m_entity_manager->GetEntityId(entity_1_tag);
-            m_entity_manager->SetEntityState(bullet_id, EntityState::INACTIVE);
-            if(strcmp(entity_2_tag, "enemy") == 0)
+            if(!m_entity_manager->IsAlive(contacts->entity_ids[i]) || !m_entity_manager->IsAlive(contacts->other_entity_ids[i]))
+            {
+                continue;
+            }
+            uint32_t entity_1_id = GetEntityIndex(contacts->entity_ids[i]);
+            uint32_t entity_2_id = GetEntityIndex(contacts->other_entity_ids[i]);
+            if(!m_component_manager->HasComponent<CollisionLayer>(entity_1_id) ||
+               !m_component_manager->HasComponent<CollisionLayer>(entity_2_id))
             {
-                uint32_t player_id = m_entity_manager->GetEntityId("player");
-                PlayerInput& player_input = m_component_manager->GetComponent<PlayerInput>(player_id);
-                player_input.score += 1;
+                continue;
+            }
+
+            uint32_t entity_1_category = m_component_manager->GetComponent<CollisionLayer>(entity_1_id).category;
+            uint32_t entity_2_category = m_component_manager->GetComponent<CollisionLayer>(entity_2_id).category;
+
+            if(entity_1_category & BULLET_COLLISION_LAYER)
+            {
+                // Other systems still get this contact, so the bullet is
+                // only destroyed on the next update
+                m_entity_manager->SetEntityState(entity_1_id, EntityState::INACTIVE);
+                if(entity_2_category & ENEMY_COLLISION_LAYER && player_id != invalid_entity_id)
+                {
+                    PlayerInput& player_input = m_component_manager->GetComponent<PlayerInput>(player_id);
+                    player_input.score += 1;
+                }
             }
         }
     }
@@ -47,18 +87,19 @@ void PlayerInputSystem::HandleMessage(Message message)
 
 void PlayerInputSystem::HandleEntity(uint32_t entity_id, float delta_time)
 {
+    UpdateBullets(delta_time);
+
     PlayerInput& player_input = m_component_manager->GetComponent<PlayerInput>(entity_id);
-    uint32_t timer_entity_id = m_entity_manager->GetEntityId("timer_entity");
-    uint32_t win_entity_id = m_entity_manager->GetEntityId("win_entity");
-    uint32_t lose_entity_id = m_entity_manager->GetEntityId("lose_entity");
+    uint32_t timer_entity_id = m_entity_manager->GetEntityId(m_timer_tag_id);
+    uint32_t win_entity_id = m_entity_manager->GetEntityId(m_win_tag_id);
+    uint32_t lose_entity_id = m_entity_manager->GetEntityId(m_lose_tag_id);
 
     if(player_input.state == PlayerState::INIT)
     {
         if(m_input_map.IsPressed(GLFW_KEY_SPACE))
         {
             player_input.state = PlayerState::RUNNING;
-            uint32_t title_entity_id = m_entity_manager->GetEntityId("title_entity");
-            uint32_t timer_entity_id = m_entity_manager->GetEntityId("timer_entity");
+            uint32_t title_entity_id = m_entity_manager->GetEntityId(m_title_tag_id);
             m_entity_manager->SetEntityState(title_entity_id, EntityState::INACTIVE);
             m_entity_manager->SetEntityState(timer_entity_id, EntityState::ACTIVE);
         }
@@ -72,8 +113,11 @@ void PlayerInputSystem::HandleEntity(uint32_t entity_id, float delta_time)
             return;
         }
         player_input.timer -= delta_time;
-        Label& label = m_component_manager->GetComponent<Label>(timer_entity_id);
-        sprintf(label.text, "%d", (int)player_input.timer);
+        if(timer_entity_id != invalid_entity_id)
+        {
+            Label& label = m_component_manager->GetComponent<Label>(timer_entity_id);
+            sprintf(label.text, "%d", (int)player_input.timer);
+        }
         if(player_input.timer <= 0)
         {
             player_input.state = PlayerState::GAMEOVER;
@@ -99,7 +143,7 @@ void PlayerInputSystem::HandleEntity(uint32_t entity_id, float delta_time)
             send_message = true;
         }
 
-        uint32_t crosshair_entity_id = m_entity_manager->GetEntityId("crosshair");
+        uint32_t crosshair_entity_id = m_entity_manager->GetEntityId(m_crosshair_tag_id);
         
         if(!m_zoom_on && m_input_map.IsPressed(GLFW_MOUSE_BUTTON_RIGHT) && !m_xray_on)
         {
@@ -135,33 +179,7 @@ void PlayerInputSystem::HandleEntity(uint32_t entity_id, float delta_time)
         if(m_zoom_on && m_shoot_timer <= 0 && m_input_map.IsPressed(GLFW_MOUSE_BUTTON_LEFT))
         {
             m_shoot_timer = 1;
-            char bullet_tag[10];
-            sprintf(bullet_tag, "bullet_%d", m_bullet_index);
-            uint32_t bullet_id = m_entity_manager->GetEntityId(bullet_tag);
-            Transform& bullet_transform = m_component_manager->GetComponent<Transform>(bullet_id);
-            RigidBody& bullet_rigid_body = m_component_manager->GetComponent<RigidBody>(bullet_id);
-
-            bullet_transform.position[0] = transform.position[0];
-            bullet_transform.position[1] = transform.position[1];
-            bullet_transform.position[2] = transform.position[2];
-
-            vec4 bullet_velocity = { 0.0, 0.0, -200.0, 1.0 };
-
-            mat4x4 rotation_matrix;
-            mat4x4_identity(rotation_matrix);
-            mat4x4_rotate_Z(rotation_matrix, rotation_matrix, transform.rotation[2] * M_PI / 180.0);
-            mat4x4_rotate_Y(rotation_matrix, rotation_matrix, transform.rotation[1] * M_PI / 180.0);
-            mat4x4_rotate_X(rotation_matrix, rotation_matrix, transform.rotation[0] * M_PI / 180.0);
-
-            vec4 rotated_bullet_veolcity;
-            mat4x4_mul_vec4(rotated_bullet_veolcity, rotation_matrix, bullet_velocity);
-
-            bullet_rigid_body.velocity[0] = rotated_bullet_veolcity[0];
-            bullet_rigid_body.velocity[1] = rotated_bullet_veolcity[1];
-            bullet_rigid_body.velocity[2] = rotated_bullet_veolcity[2];
-
-            m_entity_manager->SetEntityState(bullet_id, EntityState::ACTIVE);
-            m_entity_manager->SetEntitySignature(bullet_id, PHYSICS_SYSTEM_SIGNATURE | COLLISION_SYSTEM_SIGNATURE);
+            SpawnBullet(transform);
         }
 
         // Handle player movement    
@@ -235,6 +253,7 @@ void PlayerInputSystem::HandleEntity(uint32_t entity_id, float delta_time)
 
         if(transform.position[0] < -15) transform.position[0] = -15;
         if(transform.position[0] > 15) transform.position[0] = 15;
+        MarkTransformChanged(entity_id);
     }
     else if(player_input.state == PlayerState::GAMEOVER)
     {
@@ -245,7 +264,7 @@ void PlayerInputSystem::HandleEntity(uint32_t entity_id, float delta_time)
             message.message_data = 0;
             m_zoom_on = false;
             m_message_bus.PostMessage(message);
-            uint32_t crosshair_entity_id = m_entity_manager->GetEntityId("crosshair");
+            uint32_t crosshair_entity_id = m_entity_manager->GetEntityId(m_crosshair_tag_id);
             m_entity_manager->SetEntityState(crosshair_entity_id, EntityState::INACTIVE);
 
             message.message_type = MessageType::XRAY;
@@ -264,13 +283,120 @@ void PlayerInputSystem::HandleEntity(uint32_t entity_id, float delta_time)
             transform.position[0] = 0;
             transform.position[1] = 1;
             transform.position[2] = 0;
+            rigid_body.previous_position[0] = 0;
+            rigid_body.previous_position[1] = 1;
+            rigid_body.previous_position[2] = 0;
             transform.rotation[0] = 0;
             transform.rotation[1] = 0;
             transform.rotation[2] = 0;
+            MarkTransformChanged(entity_id);
 
             message.message_type = MessageType::RESTART;
             m_message_bus.PostMessage(message);
         }
     }
     
-}
\ No newline at end of file
+}
+
+// Bullets are created on demand and recycled through the entity free list
+void PlayerInputSystem::SpawnBullet(const Transform& transform)
+{
+    EntityHandle bullet_handle = m_entity_manager->Create();
+    if(bullet_handle == invalid_entity_handle)
+    {
+        return;
+    }
+    uint32_t bullet_id = GetEntityIndex(bullet_handle);
+
+    Transform bullet_transform;
+    memset(&bullet_transform, 0, sizeof(Transform));
+    bullet_transform.position[0] = transform.position[0];
+    bullet_transform.position[1] = transform.position[1];
+    bullet_transform.position[2] = transform.position[2];
+
+    Texture texture;
+    texture.texture_index = 2;
+    texture.position[0] = 0;
+    texture.position[1] = 257;
+    texture.size[0] = 63;
+    texture.size[1] = 63;
+
+    Quad quad;
+    quad.extent[0] = 0.1;
+    quad.extent[1] = 0.1;
+
+    BoundingBox bounding_box;
+    bounding_box.extent[0] = 0.1;
+    bounding_box.extent[1] = 0.1;
+    bounding_box.extent[2] = 0.1;
+
+    CollisionLayer collision_layer;
+    collision_layer.category = BULLET_COLLISION_LAYER;
+    collision_layer.collides_with = ALL_COLLISION_LAYERS;
+    collision_layer.reports_to = ENEMY_COLLISION_LAYER;
+
+    vec4 bullet_velocity = { 0.0, 0.0, -200.0, 1.0 };
+
+    mat4x4 rotation_matrix;
+    mat4x4_identity(rotation_matrix);
+    mat4x4_rotate_Z(rotation_matrix, rotation_matrix, transform.rotation[2] * M_PI / 180.0);
+    mat4x4_rotate_Y(rotation_matrix, rotation_matrix, transform.rotation[1] * M_PI / 180.0);
+    mat4x4_rotate_X(rotation_matrix, rotation_matrix, transform.rotation[0] * M_PI / 180.0);
+
+    vec4 rotated_bullet_veolcity;
+    mat4x4_mul_vec4(rotated_bullet_veolcity, rotation_matrix, bullet_velocity);
+
+    RigidBody rigid_body;
+    rigid_body.velocity[0] = rotated_bullet_veolcity[0];
+    rigid_body.velocity[1] = rotated_bullet_veolcity[1];
+    rigid_body.velocity[2] = rotated_bullet_veolcity[2];
+    rigid_body.acceleration[0] = 0;
+    rigid_body.acceleration[1] = 0;
+    rigid_body.acceleration[2] = 0;
+    rigid_body.previous_position[0] = transform.position[0];
+    rigid_body.previous_position[1] = transform.position[1];
+    rigid_body.previous_position[2] = transform.position[2];
+
+    m_component_manager->AddComponent<Transform>(bullet_id, bullet_transform);
+    m_component_manager->AddComponent<Texture>(bullet_id, texture);
+    m_component_manager->AddComponent<Quad>(bullet_id, quad);
+    m_component_manager->AddComponent<BoundingBox>(bullet_id, bounding_box);
+    m_component_manager->AddComponent<CollisionLayer>(bullet_id, collision_layer);
+    m_component_manager->AddComponent<RigidBody>(bullet_id, rigid_body);
+
+    m_entity_manager->SetEntityState(bullet_id, EntityState::ACTIVE);
+    m_entity_manager->SetEntitySignature(bullet_id, PHYSICS_SYSTEM_SIGNATURE | COLLISION_SYSTEM_SIGNATURE);
+
+    Bullet bullet;
+    bullet.handle = bullet_handle;
+    bullet.lifetime = bullet_lifetime;
+    m_bullets.push_back(bullet);
+}
+
+// Destroys bullets that hit something or flew for too long
+void PlayerInputSystem::UpdateBullets(float delta_time)
+{
+    uint32_t i = 0;
+    while(i < m_bullets.size())
+    {
+        Bullet& bullet = m_bullets[i];
+        bullet.lifetime -= delta_time;
+
+        uint32_t bullet_id = GetEntityIndex(bullet.handle);
+        bool is_alive = m_entity_manager->IsAlive(bullet.handle);
+        if(is_alive && bullet.lifetime > 0 && m_entity_manager->GetEntityState(bullet_id) == EntityState::ACTIVE)
+        {
+            i++;
+            continue;
+        }
+
+        // A stale handle means the slot already belongs to someone else
+        if(is_alive)
+        {
+            m_entity_manager->Destroy(bullet.handle);
+            m_component_manager->RemoveAllComponents(bullet_id);
+        }
+        m_bullets[i] = m_bullets.back();
+        m_bullets.pop_back();
+    }
+}
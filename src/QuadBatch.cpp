@@ -0,0 +1,126 @@
+#include <algorithm>
+
+#include "QuadBatch.hpp"
+
+namespace
+{
+    struct QuadKeyLess
+    {
+        template <typename T>
+        bool operator()(const T& a, const T& b) const
+        {
+            return a.key < b.key;
+        }
+    };
+}
+
+QuadBatch::QuadBatch()
+{
+
+}
+
+QuadBatch::~QuadBatch()
+{
+
+}
+
+void QuadBatch::Clear()
+{
+    m_keys.clear();
+    m_unsorted_vertices.clear();
+    m_vertices.clear();
+    m_ranges.clear();
+}
+
+void QuadBatch::AddQuad(uint32_t program_index, uint32_t texture_index, mat4x4 model_matrix,
+                        float half_width, float half_height, float u1, float v1, float u2, float v2, bool use_light)
+{
+    QuadKey quad_key;
+    quad_key.key = ((uint64_t)program_index << 32) | texture_index;
+    quad_key.quad_index = m_keys.size();
+    m_keys.push_back(quad_key);
+
+    vec4 corners[4] = { { -half_width,  half_height, 0, 1 },
+                        { -half_width, -half_height, 0, 1 },
+                        {  half_width,  half_height, 0, 1 },
+                        {  half_width, -half_height, 0, 1 } };
+    float uvs[4][2] = { { u1, v2 },
+                        { u1, v1 },
+                        { u2, v2 },
+                        { u2, v1 } };
+
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        vec4 world_position;
+        mat4x4_mul_vec4(world_position, model_matrix, corners[i]);
+
+        BatchVertex vertex;
+        vertex.x = world_position[0];
+        vertex.y = world_position[1];
+        vertex.z = world_position[2];
+        vertex.u = uvs[i][0];
+        vertex.v = uvs[i][1];
+        vertex.use_light = use_light ? 1.0f : 0.0f;
+        vertex.layer = texture_index;
+        m_unsorted_vertices.push_back(vertex);
+    }
+}
+
+void QuadBatch::Build()
+{
+    std::stable_sort(m_keys.begin(), m_keys.end(), QuadKeyLess());
+
+    m_vertices.resize(m_unsorted_vertices.size());
+    m_ranges.clear();
+    for(uint32_t i = 0; i < m_keys.size(); i++)
+    {
+        const BatchVertex* source = &m_unsorted_vertices[m_keys[i].quad_index * 4];
+        std::copy(source, source + 4, &m_vertices[i * 4]);
+
+        if(i == 0 || m_keys[i].key != m_keys[i - 1].key)
+        {
+            QuadBatchRange range;
+            range.program_index = m_keys[i].key >> 32;
+            range.texture_index = m_keys[i].key & 0xFFFFFFFF;
+            range.first_quad = i;
+            range.num_quads = 0;
+            m_ranges.push_back(range);
+        }
+        m_ranges.back().num_quads++;
+    }
+}
+
+uint32_t QuadBatch::GetNumQuads()
+{
+    return m_keys.size();
+}
+
+uint32_t QuadBatch::GetNumRanges()
+{
+    return m_ranges.size();
+}
+
+const QuadBatchRange& QuadBatch::GetRange(uint32_t index)
+{
+    return m_ranges[index];
+}
+
+const BatchVertex* QuadBatch::GetVertices()
+{
+    return m_vertices.empty() ? NULL : &m_vertices[0];
+}
+
+void QuadBatch::BuildIndices(uint32_t num_quads, std::vector<uint32_t>& indices)
+{
+    indices.resize(num_quads * 6);
+    for(uint32_t i = 0; i < num_quads; i++)
+    {
+        uint32_t first_vertex = i * 4;
+        indices[i * 6 + 0] = first_vertex + 0;
+        indices[i * 6 + 1] = first_vertex + 1;
+        indices[i * 6 + 2] = first_vertex + 2;
+        indices[i * 6 + 3] = first_vertex + 2;
+        indices[i * 6 + 4] = first_vertex + 1;
+        indices[i * 6 + 5] = first_vertex + 3;
+    }
+}
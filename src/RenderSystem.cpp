@@ -1,114 +1,129 @@
 #include <vector>
 #include <algorithm>
 #include <cstdio>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include <cstring>
+#include <cmath>
 
 #include <glad/gl.h>
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
 #include "RenderSystem.hpp"
+#include "TextureArray.hpp"
+#include "LightGrid.hpp"
 
 static const char* quad_vertex_shader_text =
 "#version 330\n"
-"uniform mat4 M;\n"
-"uniform mat4 V;\n"
-"uniform mat4 P;\n"
+"layout(std140) uniform FrameConstants\n"
+"{\n"
+"    mat4 V;\n"
+"    mat4 P;\n"
+"};\n"
 "layout(location = 0)in vec3 vPos;\n"
 "layout(location = 1)in vec2 vTexCoord;\n"
+"layout(location = 2)in float vUseLight;\n"
+"layout(location = 3)in float vLayer;\n"
 "out vec2 fTexCoord;\n"
 "out vec4 fFragPos;\n"
+"flat out float fUseLight;\n"
+"flat out float fLayer;\n"
 "void main()\n"
 "{\n"
-"    gl_Position = P * V * M * vec4(vPos, 1.0);\n"
+"    gl_Position = P * V * vec4(vPos, 1.0);\n"
 "    fTexCoord = vTexCoord;\n"
-"    fFragPos = M * vec4(vPos, 1.0);\n"
+"    fFragPos = vec4(vPos, 1.0);\n"
+"    fUseLight = vUseLight;\n"
+"    fLayer = vLayer;\n"
 "}\n";
  
 static const char* quad_fragment_shader_text =
 "#version 330\n"
-"uniform bool use_light;\n"
+"flat in float fUseLight;\n"
+"flat in float fLayer;\n"
 "in vec2 fTexCoord\n;"
 "in vec4 fFragPos;\n"
 "out vec4 fragColor;\n"
-"uniform sampler2D quadTexture;\n"
+"uniform sampler2DArray quadTexture;\n"
+"uniform samplerBuffer lightData;\n"
+"uniform usamplerBuffer lightCells;\n"
+"uniform usamplerBuffer lightIndices;\n"
+"layout(std140) uniform LightGridConstants\n"
+"{\n"
+"    vec4 lightGridOrigin;\n"
+"    ivec4 lightGridDimensions;\n"
+"};\n"
 "void main()\n"
 "{\n"
-"    vec3 light_pos[25];\n"
-"    light_pos[0] = vec3(-10.0, 2.5, 0.0);\n"
-"    light_pos[1] = vec3(-5.0, 2.5, 0.0);\n"
-"    light_pos[2] = vec3(0.0, 2.5, 0.0);\n"
-"    light_pos[3] = vec3(5.0, 2.5, 0.0);\n"
-"    light_pos[4] = vec3(10.0, 2.5, 0.0);\n"
-"    light_pos[5] = vec3(-10.0, 5, -10.0);\n"
-"    light_pos[6] = vec3(-5.0, 5, -10.0);\n"
-"    light_pos[7] = vec3(0.0, 5, -10.0);\n"
-"    light_pos[8] = vec3(5.0, 5, -10.0);\n"
-"    light_pos[9] = vec3(10.0, 5, -10.0);\n"
-"    light_pos[10] = vec3(-10.0, 2.5, -10.0);\n"
-"    light_pos[11] = vec3(-5.0, 2.5, -10.0);\n"
-"    light_pos[12] = vec3(0.0, 2.5, -10.0);\n"
-"    light_pos[13] = vec3(5.0, 2.5, -10.0);\n"
-"    light_pos[14] = vec3(10.0, 2.5, -10.0);\n"
-"    light_pos[15] = vec3(-10.0, 0, -10.0);\n"
-"    light_pos[16] = vec3(-5.0, 0, -10.0);\n"
-"    light_pos[17] = vec3(0.0, 0, -10.0);\n"
-"    light_pos[18] = vec3(5.0, 0, -10.0);\n"
-"    light_pos[19] = vec3(10.0, 0, -10.0);\n"
-"    light_pos[20] = vec3(-10.0, -2.5, -10.0);\n"
-"    light_pos[21] = vec3(-5.0, -2.5, -10.0);\n"
-"    light_pos[22] = vec3(0.0, -2.5, -10.0);\n"
-"    light_pos[23] = vec3(5.0, -2.5, -10.0);\n"
-"    light_pos[24] = vec3(10.0, -2.5, -10.0);\n"
-"    float diffuseStrength = 0.0;\n"
-"    for(int i = 0; i < 25; i++)\n"
+"    vec3 diffuse = vec3(0.0, 0.0, 0.0);\n"
+"    ivec3 cell = ivec3(floor((fFragPos.xyz - lightGridOrigin.xyz) / lightGridOrigin.w));\n"
+"    if(all(greaterThanEqual(cell, ivec3(0))) && all(lessThan(cell, lightGridDimensions.xyz)))\n"
 "    {\n"
-"       float distance = sqrt(pow(fFragPos.x - light_pos[i].x, 2) + pow(fFragPos.y - light_pos[i].y, 2) + pow(fFragPos.z - light_pos[i].z, 2));\n"
-"       if(distance < 3)\n"
+"       int cell_index = (cell.z * lightGridDimensions.y + cell.y) * lightGridDimensions.x + cell.x;\n"
+"       uvec2 cell_range = texelFetch(lightCells, cell_index).xy;\n"
+"       for(uint i = 0u; i < cell_range.y; i++)\n"
 "       {\n"
-"           float diffuse = 1 - (distance / 3);\n"
-"           if(diffuse > diffuseStrength) diffuseStrength = diffuse;\n"
+"           int light_index = int(texelFetch(lightIndices, int(cell_range.x + i)).x);\n"
+"           vec4 light_position = texelFetch(lightData, light_index * 2);\n"
+"           vec3 light_color = texelFetch(lightData, light_index * 2 + 1).xyz;\n"
+"           float light_distance = distance(fFragPos.xyz, light_position.xyz);\n"
+"           if(light_distance < light_position.w)\n"
+"           {\n"
+"               diffuse = max(diffuse, (1 - (light_distance / light_position.w)) * light_color);\n"
+"           }\n"
 "       }\n"
 "    }\n"
 "    float ambientStrength = 0.1;\n"
-"    diffuseStrength = clamp(diffuseStrength, 0.0, 1.0);\n"
-"    vec3 diffuse = diffuseStrength * vec3(0.5, 0.5, 0.5);\n"
 "    vec3 ambient = ambientStrength * vec3(1.0, 1.0, 1.0);\n"
-"    if(use_light)\n"
+"    if(fUseLight > 0.5)\n"
 "    {\n"
-"       fragColor = (vec4(ambient, 1.0) + vec4(diffuse, 1.0)) * texture(quadTexture, fTexCoord);\n"
+"       fragColor = (vec4(ambient, 1.0) + vec4(diffuse, 1.0)) * texture(quadTexture, vec3(fTexCoord, fLayer));\n"
 "    }\n"
 "    else\n"
 "    {\n"
-"       fragColor = vec4(ambient, 1.0) * texture(quadTexture, fTexCoord);\n"
+"       fragColor = vec4(ambient, 1.0) * texture(quadTexture, vec3(fTexCoord, fLayer));\n"
 "    }\n"
 "    if(fragColor.w == 0) discard;\n"
 "}\n";
 
 static const char* xray_vertex_shader_text =
 "#version 330\n"
-"uniform mat4 M;\n"
-"uniform mat4 V;\n"
-"uniform mat4 P;\n"
+"layout(std140) uniform FrameConstants\n"
+"{\n"
+"    mat4 V;\n"
+"    mat4 P;\n"
+"};\n"
 "layout(location = 0)in vec3 vPos;\n"
 "layout(location = 1)in vec2 vTexCoord;\n"
+"layout(location = 2)in float vUseLight;\n"
+"layout(location = 3)in float vLayer;\n"
 "out vec2 fTexCoord;\n"
 "out vec4 fFragPos;\n"
 "out vec4 fFragPosCamera;\n"
+"flat out float fUseLight;\n"
+"flat out float fLayer;\n"
 "void main()\n"
 "{\n"
-"    gl_Position = P * V * M * vec4(vPos, 1.0);\n"
+"    gl_Position = P * V * vec4(vPos, 1.0);\n"
 "    fTexCoord = vTexCoord;\n"
-"    fFragPos = M * vec4(vPos, 1.0);\n"
-"    fFragPosCamera = V * M * vec4(vPos, 1.0);\n"
+"    fFragPos = vec4(vPos, 1.0);\n"
+"    fFragPosCamera = V * vec4(vPos, 1.0);\n"
+"    fUseLight = vUseLight;\n"
+"    fLayer = vLayer;\n"
 "}\n";
  
 static const char* xray_fragment_shader_text =
 "#version 330\n"
-"uniform bool use_light;\n"
-"uniform sampler2D quadTexture;\n"
+"flat in float fUseLight;\n"
+"flat in float fLayer;\n"
+"uniform sampler2DArray quadTexture;\n"
+"uniform samplerBuffer lightData;\n"
+"uniform usamplerBuffer lightCells;\n"
+"uniform usamplerBuffer lightIndices;\n"
+"layout(std140) uniform LightGridConstants\n"
+"{\n"
+"    vec4 lightGridOrigin;\n"
+"    ivec4 lightGridDimensions;\n"
+"};\n"
 "out vec4 fNormal;\n"
 "in vec2 fTexCoord\n;"
 "in vec4 fFragPos;\n"
@@ -116,45 +131,25 @@ static const char* xray_fragment_shader_text =
 "out vec4 fragColor;\n"
 "void main()\n"
 "{\n"
-"    vec3 light_pos[25];\n"
-"    light_pos[0] = vec3(-10.0, 2.5, 0.0);\n"
-"    light_pos[1] = vec3(-5.0, 2.5, 0.0);\n"
-"    light_pos[2] = vec3(0.0, 2.5, 0.0);\n"
-"    light_pos[3] = vec3(5.0, 2.5, 0.0);\n"
-"    light_pos[4] = vec3(10.0, 2.5, 0.0);\n"
-"    light_pos[5] = vec3(-10.0, 5, -10.0);\n"
-"    light_pos[6] = vec3(-5.0, 5, -10.0);\n"
-"    light_pos[7] = vec3(0.0, 5, -10.0);\n"
-"    light_pos[8] = vec3(5.0, 5, -10.0);\n"
-"    light_pos[9] = vec3(10.0, 5, -10.0);\n"
-"    light_pos[10] = vec3(-10.0, 2.5, -10.0);\n"
-"    light_pos[11] = vec3(-5.0, 2.5, -10.0);\n"
-"    light_pos[12] = vec3(0.0, 2.5, -10.0);\n"
-"    light_pos[13] = vec3(5.0, 2.5, -10.0);\n"
-"    light_pos[14] = vec3(10.0, 2.5, -10.0);\n"
-"    light_pos[15] = vec3(-10.0, 0, -10.0);\n"
-"    light_pos[16] = vec3(-5.0, 0, -10.0);\n"
-"    light_pos[17] = vec3(0.0, 0, -10.0);\n"
-"    light_pos[18] = vec3(5.0, 0, -10.0);\n"
-"    light_pos[19] = vec3(10.0, 0, -10.0);\n"
-"    light_pos[20] = vec3(-10.0, -2.5, -10.0);\n"
-"    light_pos[21] = vec3(-5.0, -2.5, -10.0);\n"
-"    light_pos[22] = vec3(0.0, -2.5, -10.0);\n"
-"    light_pos[23] = vec3(5.0, -2.5, -10.0);\n"
-"    light_pos[24] = vec3(10.0, -2.5, -10.0);\n"
-"    float diffuseStrength = 0.0;\n"
-"    for(int i = 0; i < 25; i++)\n"
+"    vec3 diffuse = vec3(0.0, 0.0, 0.0);\n"
+"    ivec3 cell = ivec3(floor((fFragPos.xyz - lightGridOrigin.xyz) / lightGridOrigin.w));\n"
+"    if(all(greaterThanEqual(cell, ivec3(0))) && all(lessThan(cell, lightGridDimensions.xyz)))\n"
 "    {\n"
-"       float distance = sqrt(pow(fFragPos.x - light_pos[i].x, 2) + pow(fFragPos.y - light_pos[i].y, 2) + pow(fFragPos.z - light_pos[i].z, 2));\n"
-"       if(distance < 3)\n"
+"       int cell_index = (cell.z * lightGridDimensions.y + cell.y) * lightGridDimensions.x + cell.x;\n"
+"       uvec2 cell_range = texelFetch(lightCells, cell_index).xy;\n"
+"       for(uint i = 0u; i < cell_range.y; i++)\n"
 "       {\n"
-"           float diffuse = 1 - (distance / 3);\n"
-"           if(diffuse > diffuseStrength) diffuseStrength = diffuse;\n"
+"           int light_index = int(texelFetch(lightIndices, int(cell_range.x + i)).x);\n"
+"           vec4 light_position = texelFetch(lightData, light_index * 2);\n"
+"           vec3 light_color = texelFetch(lightData, light_index * 2 + 1).xyz;\n"
+"           float light_distance = distance(fFragPos.xyz, light_position.xyz);\n"
+"           if(light_distance < light_position.w)\n"
+"           {\n"
+"               diffuse = max(diffuse, (1 - (light_distance / light_position.w)) * light_color);\n"
+"           }\n"
 "       }\n"
 "    }\n"
 "    float ambientStrength = 0.1;\n"
-"    diffuseStrength = clamp(diffuseStrength, 0.0, 1.0);\n"
-"    vec3 diffuse = diffuseStrength * vec3(0.5, 0.5, 0.5);\n"
 "    vec3 ambient = ambientStrength * vec3(1.0, 1.0, 1.0);\n"
 
 "    float vision_angle = radians(15.0);\n"
@@ -166,422 +161,733 @@ static const char* xray_fragment_shader_text =
 "    float opacity = 1.0;\n"
 "    if(look_center_distance < radius) discard;\n"
 
-"    if(use_light)\n"
+"    if(fUseLight > 0.5)\n"
 "    {\n"
-"       fragColor = (vec4(ambient, 1.0) + vec4(diffuse, 1.0)) * texture(quadTexture, fTexCoord);\n"
+"       fragColor = (vec4(ambient, 1.0) + vec4(diffuse, 1.0)) * texture(quadTexture, vec3(fTexCoord, fLayer));\n"
 "    }\n"
 "    else\n"
 "    {\n"
-"       fragColor = vec4(ambient, 1.0) * texture(quadTexture, fTexCoord);\n"
+"       fragColor = vec4(ambient, 1.0) * texture(quadTexture, vec3(fTexCoord, fLayer));\n"
 "    }\n"
 "    if(fragColor.w == 0) discard;\n"
 "}\n";
 
-struct VertexData
-{
-    float x;
-    float y;
-    float z;
-    float u;
-    float v;
-};
-
-RenderSystem::RenderSystem(MessageBus& message_bus, InputMap& input_map) : 
+const uint32_t quad_program_index = 0;
+const uint32_t xray_program_index = 1;
+const uint32_t invalid_program_index = 0xFFFFFFFF;
+const uint32_t frame_constants_binding = 0;
+const uint32_t light_grid_constants_binding = 1;
+const uint32_t light_data_texture_unit = 1;
+const uint32_t light_cells_texture_unit = 2;
+const uint32_t light_indices_texture_unit = 3;
+const float light_grid_cell_size = 3;
+const uint32_t max_light_grid_cells = 32768;
+const uint32_t num_textures = 7;
+const uint32_t texture_layer_size = 512;
+const uint32_t num_texture_layer_levels = 10;
+const float static_chunk_size = 8;
+
+RenderSystem::RenderSystem(MessageBus& message_bus, InputMap& input_map, ShaderCache& shader_cache, AssetLoader& asset_loader) : 
     System(message_bus, RENDER_SYSTEM_SIGNATURE),
     m_input_map(input_map),
     m_zoom_on(false),
-    m_xray_on(false)
+    m_xray_on(false),
+    m_player_tag_id(invalid_tag_id),
+    m_interpolation_alpha(1),
+    m_shader_program(0),
+    m_xray_program(0),
+    m_vpos_location(-1),
+    m_vtexcoord_location(-1),
+    m_vuselight_location(-1),
+    m_vlayer_location(-1),
+    m_asset_loader(asset_loader),
+    m_num_pending_textures(0),
+    m_generate_texture_mipmaps(false),
+    m_vertex_buffer(0),
+    m_index_buffer(0),
+    m_batch_capacity(0),
+    m_static_geometry(static_chunk_size),
+    m_static_vertex_buffer(0),
+    m_static_index_buffer(0),
+    m_light_query_id(invalid_query_id),
+    m_light_grid(light_grid_cell_size, max_light_grid_cells),
+    m_lights_valid(false),
+    m_light_grid_constants_buffer(0),
+    m_light_data_buffer(0),
+    m_light_data_texture(0),
+    m_light_cells_buffer(0),
+    m_light_cells_texture(0),
+    m_light_indices_buffer(0),
+    m_light_indices_texture(0),
+    m_frame_constants_buffer(0),
+    m_frame_constants_valid(false),
+    m_frame_zoom_on(false)
 {
-    uint32_t texture_index = 0;
-    glGenTextures(1, &m_textures[texture_index]);
-    glBindTexture(GL_TEXTURE_2D, m_textures[texture_index]);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    int32_t num_channels;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char *data = stbi_load("assets/BrickTexture.png", &m_texture_sizes[texture_index][0], &m_texture_sizes[texture_index][1], &num_channels, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_texture_sizes[texture_index][0], m_texture_sizes[texture_index][1], 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
-    
-    texture_index++;
-    glGenTextures(1, &m_textures[texture_index]);
-    glBindTexture(GL_TEXTURE_2D, m_textures[texture_index]);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    data = stbi_load("assets/AtlasTexture.png", &m_texture_sizes[texture_index][0], &m_texture_sizes[texture_index][1], &num_channels, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_texture_sizes[texture_index][0], m_texture_sizes[texture_index][1], 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
-    
-    texture_index++;
-    glGenTextures(1, &m_textures[texture_index]);
-    glBindTexture(GL_TEXTURE_2D, m_textures[texture_index]);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    data = stbi_load("assets/WallTexture.png", &m_texture_sizes[texture_index][0], &m_texture_sizes[texture_index][1], &num_channels, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_texture_sizes[texture_index][0], m_texture_sizes[texture_index][1], 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
-    
-    texture_index++;
-    glGenTextures(1, &m_textures[texture_index]);
-    glBindTexture(GL_TEXTURE_2D, m_textures[texture_index]);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    data = stbi_load("assets/CarpetTexture.png", &m_texture_sizes[texture_index][0], &m_texture_sizes[texture_index][1], &num_channels, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_texture_sizes[texture_index][0], m_texture_sizes[texture_index][1], 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
-    
-    texture_index++;
-    glGenTextures(1, &m_textures[texture_index]);
-    glBindTexture(GL_TEXTURE_2D, m_textures[texture_index]);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    data = stbi_load("assets/CeilingTexture.png", &m_texture_sizes[texture_index][0], &m_texture_sizes[texture_index][1], &num_channels, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_texture_sizes[texture_index][0], m_texture_sizes[texture_index][1], 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
-    
-    texture_index++;
-    glGenTextures(1, &m_textures[texture_index]);
-    glBindTexture(GL_TEXTURE_2D, m_textures[texture_index]);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    data = stbi_load("assets/GroundTextureAtlas.png", &m_texture_sizes[texture_index][0], &m_texture_sizes[texture_index][1], &num_channels, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_texture_sizes[texture_index][0], m_texture_sizes[texture_index][1], 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
-    
-    texture_index++;
-    glGenTextures(1, &m_textures[texture_index]);
-    glBindTexture(GL_TEXTURE_2D, m_textures[texture_index]);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    data = stbi_load("assets/EnemyTexture.png", &m_texture_sizes[texture_index][0], &m_texture_sizes[texture_index][1], &num_channels, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_texture_sizes[texture_index][0], m_texture_sizes[texture_index][1], 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
-    
-    // Normal Shader
-    GLuint quad_render_vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(quad_render_vertex_shader, 1, &quad_vertex_shader_text, NULL);
-    glCompileShader(quad_render_vertex_shader);
-
-    GLint isCompiled = 0;
-    glGetShaderiv(quad_render_vertex_shader, GL_COMPILE_STATUS, &isCompiled);
-    if(isCompiled == GL_FALSE)
-    {
-        GLint maxLength = 0;
-        glGetShaderiv(quad_render_vertex_shader, GL_INFO_LOG_LENGTH, &maxLength);
-
-        // The maxLength includes the NULL character
-        std::vector<GLchar> errorLog(maxLength);
-        glGetShaderInfoLog(quad_render_vertex_shader, maxLength, &maxLength, &errorLog[0]);
-        printf("%s\n", errorLog.data());
-
-        // Provide the infolog in whatever manor you deem best.
-        // Exit with failure.
-        glDeleteShader(quad_render_vertex_shader); // Don't leak the shader.
-        return;
+    DeclareAccess(TRANSFORM_ACCESS | RIGID_BODY_ACCESS | QUAD_ACCESS | TEXTURE_ACCESS | LIGHT_ACCESS | ENTITY_STATE_ACCESS, MODEL_MATRIX_ACCESS, false);
+    Subscribe(XRAY);
+    Subscribe(ZOOM);
+    memset(&m_render_stats, 0, sizeof(RenderStats));
+
+    // Every texture becomes a layer of one array texture, so the whole frame
+    // draws with a single texture bound. Layers start out as flat grey and
+    // are replaced by UpdateTextures as the loader finishes decoding them.
+    const char* texture_files[num_textures] = { "assets/BrickTexture.png",
+                                                "assets/AtlasTexture.png",
+                                                "assets/WallTexture.png",
+                                                "assets/CarpetTexture.png",
+                                                "assets/CeilingTexture.png",
+                                                "assets/GroundTextureAtlas.png",
+                                                "assets/EnemyTexture.png" };
+    const unsigned char placeholder_texel[4] = { 128, 128, 128, 255 };
+    TextureArray texture_array(texture_layer_size, texture_layer_size);
+    for(uint32_t i = 0; i < num_textures; i++)
+    {
+        m_texture_image_ids.push_back(m_asset_loader.LoadImage(texture_files[i], 4));
+        texture_array.AddLayer(placeholder_texel, 1, 1);
     }
- 
-    GLuint quad_render_fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(quad_render_fragment_shader, 1, &quad_fragment_shader_text, NULL);
-    glCompileShader(quad_render_fragment_shader);
+    m_num_pending_textures = num_textures;
 
-    isCompiled = 0;
-    glGetShaderiv(quad_render_fragment_shader, GL_COMPILE_STATUS, &isCompiled);
-    if(isCompiled == GL_FALSE)
-    {
-        GLint maxLength = 0;
-        glGetShaderiv(quad_render_fragment_shader, GL_INFO_LOG_LENGTH, &maxLength);
+    glGenTextures(1, &m_texture_array);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture_array);
 
-        // The maxLength includes the NULL character
-        std::vector<GLchar> errorLog(maxLength);
-        glGetShaderInfoLog(quad_render_fragment_shader, maxLength, &maxLength, &errorLog[0]);
-        printf("%s\n", errorLog.data());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // Keep the texels sharp but sample the mips UpdateTextures uploads
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-        // Provide the infolog in whatever manor you deem best.
-        // Exit with failure.
-        glDeleteShader(quad_render_fragment_shader); // Don't leak the shader.
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, texture_array.GetLayerWidth(), texture_array.GetLayerHeight(),
+                 texture_array.GetNumLayers(), 0, GL_RGBA, GL_UNSIGNED_BYTE, texture_array.GetPixels());
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    
+    m_shader_program = shader_cache.GetProgram(quad_vertex_shader_text, quad_fragment_shader_text);
+    m_xray_program = shader_cache.GetProgram(xray_vertex_shader_text, xray_fragment_shader_text);
+    if(m_shader_program == 0 || m_xray_program == 0)
+    {
         return;
     }
- 
-    m_shader_program = glCreateProgram();
-    glAttachShader(m_shader_program, quad_render_vertex_shader);
-    glAttachShader(m_shader_program, quad_render_fragment_shader);
-    glLinkProgram(m_shader_program);
     
-    GLint status; 
-    glGetProgramiv( m_shader_program, GL_LINK_STATUS, &status ); 
-    if( GL_FALSE == status ) {
-        GLint maxLength = 0;
-        glGetProgramiv(m_shader_program, GL_INFO_LOG_LENGTH, &maxLength);
-
-        // The maxLength includes the NULL character
-        std::vector<GLchar> errorLog(maxLength);
-        glGetProgramInfoLog(m_shader_program, maxLength, &maxLength, &errorLog[0]);
-        printf("%s\n", errorLog.data());
-
-        // Provide the infolog in whatever manor you deem best.
-        // Exit with failure.
-        glDeleteProgram(m_shader_program); // Don't leak the shader.
+    // Both programs share the layout below, so look the attributes up once
+    m_vpos_location = shader_cache.GetAttribLocation(m_shader_program, "vPos");
+    m_vtexcoord_location = shader_cache.GetAttribLocation(m_shader_program, "vTexCoord");
+    m_vuselight_location = shader_cache.GetAttribLocation(m_shader_program, "vUseLight");
+    m_vlayer_location = shader_cache.GetAttribLocation(m_shader_program, "vLayer");
+
+    glGenBuffers(1, &m_frame_constants_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frame_constants_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, frame_constants_binding, m_frame_constants_buffer);
+    glUniformBlockBinding(m_shader_program, glGetUniformBlockIndex(m_shader_program, "FrameConstants"), frame_constants_binding);
+    glUniformBlockBinding(m_xray_program, glGetUniformBlockIndex(m_xray_program, "FrameConstants"), frame_constants_binding);
+
+    glGenBuffers(1, &m_vertex_buffer);
+    glGenBuffers(1, &m_index_buffer);
+    glGenBuffers(1, &m_static_vertex_buffer);
+    glGenBuffers(1, &m_static_index_buffer);
+
+    // Binned lights are read from texture buffers on their own units
+    glGenBuffers(1, &m_light_grid_constants_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_light_grid_constants_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightGridConstants), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, light_grid_constants_binding, m_light_grid_constants_buffer);
+
+    CreateTextureBuffer(GL_RGBA32F, light_data_texture_unit, m_light_data_buffer, m_light_data_texture);
+    CreateTextureBuffer(GL_RG32UI, light_cells_texture_unit, m_light_cells_buffer, m_light_cells_texture);
+    CreateTextureBuffer(GL_R32UI, light_indices_texture_unit, m_light_indices_buffer, m_light_indices_texture);
+
+    int32_t programs[2] = { m_shader_program, m_xray_program };
+    for(uint32_t i = 0; i < 2; i++)
+    {
+        glUniformBlockBinding(programs[i], glGetUniformBlockIndex(programs[i], "LightGridConstants"), light_grid_constants_binding);
+        glUseProgram(programs[i]);
+        glUniform1i(shader_cache.GetUniformLocation(programs[i], "lightData"), light_data_texture_unit);
+        glUniform1i(shader_cache.GetUniformLocation(programs[i], "lightCells"), light_cells_texture_unit);
+        glUniform1i(shader_cache.GetUniformLocation(programs[i], "lightIndices"), light_indices_texture_unit);
+    }
+}
+
+void RenderSystem::CreateTextureBuffer(uint32_t format, uint32_t texture_unit, uint32_t& buffer, uint32_t& texture)
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STATIC_DRAW);
+
+    glGenTextures(1, &texture);
+    glActiveTexture(GL_TEXTURE0 + texture_unit);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+RenderSystem::~RenderSystem()
+{
+
+}
+
+void RenderSystem::SetEntityManager(EntityManager* entity_manager)
+{
+    System::SetEntityManager(entity_manager);
+    m_player_tag_id = m_entity_manager->GetTagId("player");
+    m_light_query_id = m_entity_manager->RegisterQuery(LIGHT_SIGNATURE);
+}
+
+void RenderSystem::HandleMessage(Message message)
+{
+    if(message.message_type == MessageType::XRAY)
+    {
+        m_xray_on = message.message_data;
+    }
+    else if(message.message_type == MessageType::ZOOM)
+    {
+        m_zoom_on = message.message_data;
+    }
+}
+
+void RenderSystem::HandleEntity(uint32_t entity_id, float delta_time)
+{
+    // Static quads were baked into their own vertex buffer at load
+    uint32_t signature = m_entity_manager->GetEntitySignature(entity_id);
+    if(signature & STATIC_SIGNATURE)
+    {
         return;
     }
 
-    glDeleteShader(quad_render_vertex_shader);
-    glDeleteShader(quad_render_fragment_shader);
+    Transform& transform = m_component_manager->GetComponent<Transform>(entity_id);
+    Quad& quad = m_component_manager->GetComponent<Quad>(entity_id);
+    Texture& texture = m_component_manager->GetComponent<Texture>(entity_id);
 
-    GLuint xray_vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(xray_vertex_shader, 1, &xray_vertex_shader_text, NULL);
-    glCompileShader(xray_vertex_shader);
+    float half_width = quad.extent[0] / 2;
+    float half_height = quad.extent[1] / 2;
 
-    isCompiled = 0;
-    glGetShaderiv(xray_vertex_shader, GL_COMPILE_STATUS, &isCompiled);
-    if(isCompiled == GL_FALSE)
+    float texture_coordinates[4];
+    GetTextureCoordinates(texture, texture_coordinates);
+
+    // Model Matrix, rebuilt only after something wrote the Transform
+    if(!m_component_manager->HasComponent<ModelMatrix>(entity_id))
+    {
+        ModelMatrix new_model_matrix;
+        new_model_matrix.dirty = true;
+        m_component_manager->AddComponent<ModelMatrix>(entity_id, new_model_matrix);
+    }
+    ModelMatrix& cached_model_matrix = m_component_manager->GetComponent<ModelMatrix>(entity_id);
+    if(cached_model_matrix.dirty)
     {
-        GLint maxLength = 0;
-        glGetShaderiv(xray_vertex_shader, GL_INFO_LOG_LENGTH, &maxLength);
+        BuildModelMatrix(transform, cached_model_matrix.matrix);
+        cached_model_matrix.dirty = false;
+        m_render_stats.matrix_builds++;
+    }
 
-        // The maxLength includes the NULL character
-        std::vector<GLchar> errorLog(maxLength);
-        glGetShaderInfoLog(xray_vertex_shader, maxLength, &maxLength, &errorLog[0]);
-        printf("%s\n", errorLog.data());
+    // Moving bodies are drawn at their interpolated position. The matrix is
+    // translation * rotation, so only its translation column differs.
+    mat4x4 model_matrix;
+    mat4x4_dup(model_matrix, cached_model_matrix.matrix);
+    if(signature & PHYSICS_SYSTEM_SIGNATURE)
+    {
+        vec3 position;
+        GetRenderPosition(entity_id, position);
+        model_matrix[3][0] = position[0];
+        model_matrix[3][1] = position[1];
+        model_matrix[3][2] = position[2];
+    }
 
-        // Provide the infolog in whatever manor you deem best.
-        // Exit with failure.
-        glDeleteShader(xray_vertex_shader); // Don't leak the shader.
+    // The translation is the quad's center and any rotation keeps its
+    // corners within the half diagonal of it
+    vec3 center = { model_matrix[3][0], model_matrix[3][1], model_matrix[3][2] };
+    float radius = sqrtf(half_width * half_width + half_height * half_height);
+    if(!m_frustum.IntersectsSphere(center, radius))
+    {
+        m_render_stats.culled_quads++;
         return;
     }
- 
-    GLuint xray_fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(xray_fragment_shader, 1, &xray_fragment_shader_text, NULL);
-    glCompileShader(xray_fragment_shader);
+    m_render_stats.visible_quads++;
+
+    uint32_t program_index = quad_program_index;
+    if(signature & XRAY_SYSTEM_SIGNATURE && m_xray_on)
+    {
+        program_index = xray_program_index;
+    }
+
+    m_quad_batch.AddQuad(program_index, texture.texture_index, model_matrix, half_width, half_height,
+                         texture_coordinates[0], texture_coordinates[1], texture_coordinates[2], texture_coordinates[3],
+                         texture.use_light);
+}
+
+// The level never moves once it is loaded, so transform all of its quads
+// into world space once and keep them in a static vertex buffer. Groups
+// share a texture and lighting mode and are drawn with one call each.
+void RenderSystem::BakeStaticGeometry()
+{
+    m_static_geometry.Clear();
 
-    isCompiled = 0;
-    glGetShaderiv(xray_fragment_shader, GL_COMPILE_STATUS, &isCompiled);
-    if(isCompiled == GL_FALSE)
+    uint32_t num_entities = m_entity_manager->GetQuerySize(m_query_id);
+    uint32_t* entities = m_entity_manager->GetQueryEntities(m_query_id);
+    for(uint32_t i = 0; i < num_entities; i++)
     {
-        GLint maxLength = 0;
-        glGetShaderiv(xray_fragment_shader, GL_INFO_LOG_LENGTH, &maxLength);
+        uint32_t entity_id = entities[i];
+        uint32_t signature = m_entity_manager->GetEntitySignature(entity_id);
+        if(!(signature & STATIC_SIGNATURE))
+        {
+            continue;
+        }
 
-        // The maxLength includes the NULL character
-        std::vector<GLchar> errorLog(maxLength);
-        glGetShaderInfoLog(xray_fragment_shader, maxLength, &maxLength, &errorLog[0]);
-        printf("%s\n", errorLog.data());
+        Transform& transform = m_component_manager->GetComponent<Transform>(entity_id);
+        Quad& quad = m_component_manager->GetComponent<Quad>(entity_id);
+        Texture& texture = m_component_manager->GetComponent<Texture>(entity_id);
+
+        float texture_coordinates[4];
+        GetTextureCoordinates(texture, texture_coordinates);
+
+        mat4x4 model_matrix;
+        BuildModelMatrix(transform, model_matrix);
+
+        m_static_geometry.AddQuad(texture.texture_index, texture.use_light, signature & XRAY_SYSTEM_SIGNATURE,
+                                  model_matrix, quad.extent[0] / 2, quad.extent[1] / 2,
+                                  texture_coordinates[0], texture_coordinates[1], texture_coordinates[2], texture_coordinates[3]);
+    }
 
-        // Provide the infolog in whatever manor you deem best.
-        // Exit with failure.
-        glDeleteShader(xray_fragment_shader); // Don't leak the shader.
+    m_static_geometry.Build();
+
+    uint32_t num_quads = m_static_geometry.GetNumQuads();
+    if(num_quads == 0 || m_static_vertex_buffer == 0)
+    {
         return;
     }
- 
-    m_xray_program = glCreateProgram();
-    glAttachShader(m_xray_program, xray_vertex_shader);
-    glAttachShader(m_xray_program, xray_fragment_shader);
-    glLinkProgram(m_xray_program);
-    
-    status; 
-    glGetProgramiv( m_xray_program, GL_LINK_STATUS, &status ); 
-    if( GL_FALSE == status ) {
-        GLint maxLength = 0;
-        glGetProgramiv(m_xray_program, GL_INFO_LOG_LENGTH, &maxLength);
-
-        // The maxLength includes the NULL character
-        std::vector<GLchar> errorLog(maxLength);
-        glGetProgramInfoLog(m_xray_program, maxLength, &maxLength, &errorLog[0]);
-        printf("%s\n", errorLog.data());
-
-        // Provide the infolog in whatever manor you deem best.
-        // Exit with failure.
-        glDeleteProgram(m_xray_program); // Don't leak the shader.
+
+    std::vector<uint32_t> indices;
+    QuadBatch::BuildIndices(num_quads, indices);
+    glBindBuffer(GL_ARRAY_BUFFER, m_static_vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, m_static_geometry.GetNumVertices() * sizeof(BatchVertex), m_static_geometry.GetVertices(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_static_index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), &indices[0], GL_STATIC_DRAW);
+}
+
+StaticGeometry& RenderSystem::GetStaticGeometry()
+{
+    return m_static_geometry;
+}
+
+void RenderSystem::Update(float delta_time)
+{
+    memset(&m_render_stats, 0, sizeof(RenderStats));
+
+    // The constructor stopped short if either program failed to build
+    if(m_shader_program == 0 || m_xray_program == 0)
+    {
         return;
     }
 
-    glDeleteShader(xray_vertex_shader);
-    glDeleteShader(xray_fragment_shader);
-    
-    m_m_location = glGetUniformLocation(m_shader_program, "M");
-    m_v_location = glGetUniformLocation(m_shader_program, "V");
-    m_p_location = glGetUniformLocation(m_shader_program, "P");
-    
-    m_xray_m_location = glGetUniformLocation(m_xray_program, "M");
-    m_xray_v_location = glGetUniformLocation(m_xray_program, "V");
-    m_xray_p_location = glGetUniformLocation(m_xray_program, "P");
+    uint32_t camera_entity_id = m_entity_manager->GetEntityId(m_player_tag_id);
+    if(camera_entity_id != invalid_entity_id)
+    {
+        Transform& camera_transform = m_component_manager->GetComponent<Transform>(camera_entity_id);
+
+        GetRenderPosition(camera_entity_id, m_eye);
+
+        // Rotation
+        mat4x4 rotation_matrix;
+        mat4x4_identity(rotation_matrix);
+        mat4x4_rotate_Z(rotation_matrix, rotation_matrix, camera_transform.rotation[2] * M_PI / 180.0);
+        mat4x4_rotate_Y(rotation_matrix, rotation_matrix, camera_transform.rotation[1] * M_PI / 180.0);
+        mat4x4_rotate_X(rotation_matrix, rotation_matrix, camera_transform.rotation[0] * M_PI / 180.0);
+        m_render_stats.matrix_builds++;
+
+        vec4 forward = { 0, 0, -1 , 0};
+        vec4 result;
+
+        mat4x4_mul_vec4(result, rotation_matrix, forward);
+
+        m_look[0] = m_eye[0] + result[0];
+        m_look[1] = m_eye[1] + result[1];
+        m_look[2] = m_eye[2] + result[2];
+    }
+
+    UpdateFrameConstants();
+    UpdateLights();
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture_array);
+    m_render_stats.gl_calls++;
+    UpdateTextures();
+ 
+    m_quad_batch.Clear();
+    System::Update(delta_time);
+    m_quad_batch.Build();
+
+    CullStaticGeometry();
+    DrawStaticGeometry();
+    DrawQuadBatch();
 }
 
-RenderSystem::~RenderSystem()
+// View and projection are the same for every quad and only change with the
+// camera or zoom, so rebuild them here and upload them only when they change
+void RenderSystem::UpdateFrameConstants()
 {
+    bool view_changed = !m_frame_constants_valid ||
+                        memcmp(m_eye, m_frame_eye, sizeof(vec3)) != 0 ||
+                        memcmp(m_look, m_frame_look, sizeof(vec3)) != 0;
+    bool perspective_changed = !m_frame_constants_valid || m_zoom_on != m_frame_zoom_on;
+    if(!view_changed && !perspective_changed)
+    {
+        return;
+    }
 
+    if(view_changed)
+    {
+        mat4x4_look_at(m_frame_constants.view_matrix, m_eye, m_look, m_up);
+        memcpy(m_frame_eye, m_eye, sizeof(vec3));
+        memcpy(m_frame_look, m_look, sizeof(vec3));
+        m_render_stats.matrix_builds++;
+    }
+
+    if(perspective_changed)
+    {
+        if(m_zoom_on)
+        {
+            mat4x4_perspective(m_frame_constants.perspective_matrix, 30 * M_PI / 180.0, 4 / 3, 0.1, 300);
+        }
+        else
+        {
+            mat4x4_perspective(m_frame_constants.perspective_matrix, 60 * M_PI / 180.0, 4 / 3, 0.1, 300);
+        }
+        m_frame_zoom_on = m_zoom_on;
+        m_render_stats.matrix_builds++;
+    }
+
+    m_frame_constants_valid = true;
+
+    mat4x4 view_projection_matrix;
+    mat4x4_mul(view_projection_matrix, m_frame_constants.perspective_matrix, m_frame_constants.view_matrix);
+    m_frustum.Build(view_projection_matrix);
+    m_render_stats.matrix_builds++;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frame_constants_buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &m_frame_constants);
+    m_render_stats.gl_calls += 2;
 }
 
-void RenderSystem::HandleMessage(Message message)
+// Swap finished images in for their placeholder layers. The array is bound.
+void RenderSystem::UpdateTextures()
 {
-    if(message.message_type == MessageType::XRAY)
+    if(m_num_pending_textures == 0)
     {
-        m_xray_on = message.message_data;
+        return;
     }
-    else if(message.message_type == MessageType::ZOOM)
+
+    for(uint32_t i = 0; i < m_texture_image_ids.size(); i++)
     {
-        m_zoom_on = message.message_data;
+        uint32_t image_id = m_texture_image_ids[i];
+        if(image_id == invalid_image_id || !m_asset_loader.IsImageReady(image_id))
+        {
+            continue;
+        }
+
+        // Precooked images come with their mips. Tiling mip n of the image
+        // gives mip n of its layer, and past the image's last mip the layer
+        // only repeats that one texel.
+        uint32_t num_mips = m_asset_loader.GetImageNumMips(image_id);
+        uint32_t num_levels = num_mips > 1 ? num_texture_layer_levels : 1;
+        if(num_mips <= 1)
+        {
+            m_generate_texture_mipmaps = true;
+        }
+        for(uint32_t level = 0; level < num_levels && num_mips > 0; level++)
+        {
+            ImageMip mip = m_asset_loader.GetImageMip(image_id, std::min(level, num_mips - 1));
+            uint32_t level_size = texture_layer_size >> level;
+            m_layer_pixels.resize(level_size * level_size * 4);
+            TextureArray::TileImage(mip.pixels, mip.width, mip.height, level_size, level_size, &m_layer_pixels[0]);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, i, level_size, level_size, 1,
+                            GL_RGBA, GL_UNSIGNED_BYTE, &m_layer_pixels[0]);
+            m_render_stats.gl_calls++;
+        }
+        m_asset_loader.FreeImage(image_id);
+        m_texture_image_ids[i] = invalid_image_id;
+        m_num_pending_textures--;
+    }
+
+    if(m_num_pending_textures == 0)
+    {
+        if(m_generate_texture_mipmaps)
+        {
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            m_render_stats.gl_calls++;
+        }
+        std::vector<unsigned char>().swap(m_layer_pixels);
     }
 }
 
-void RenderSystem::HandleEntity(uint32_t entity_id, float delta_time)
+// Lights are binned on the CPU into world space clusters, so each fragment
+// only loops over the lights of its own cluster. They rarely move, so the
+// grid is rebuilt and uploaded only when a light changed.
+void RenderSystem::UpdateLights()
 {
-    Transform& transform = m_component_manager->GetComponent<Transform>(entity_id);
-    Quad& quad = m_component_manager->GetComponent<Quad>(entity_id);
-    Texture& texture = m_component_manager->GetComponent<Texture>(entity_id);
+    m_frame_lights.clear();
+    uint32_t num_lights = m_entity_manager->GetQuerySize(m_light_query_id);
+    uint32_t* lights = m_entity_manager->GetQueryEntities(m_light_query_id);
+    for(uint32_t i = 0; i < num_lights; i++)
+    {
+        Transform& transform = m_component_manager->GetComponent<Transform>(lights[i]);
+        Light& light = m_component_manager->GetComponent<Light>(lights[i]);
 
-    float half_width = quad.extent[0] / 2;
-    float half_height = quad.extent[1] / 2;
+        GridLight grid_light;
+        for(uint32_t j = 0; j < 3; j++)
+        {
+            grid_light.position[j] = transform.position[j];
+            grid_light.color[j] = light.color[j];
+        }
+        grid_light.radius = light.radius;
+        grid_light.padding = 0;
+        m_frame_lights.push_back(grid_light);
+    }
 
-    float u1 = texture.position[0] / m_texture_sizes[texture.texture_index][0];
-    float v1 = texture.position[1] / m_texture_sizes[texture.texture_index][1];
-    float u2 = (texture.position[0] + texture.size[0]) / m_texture_sizes[texture.texture_index][0];
-    float v2 = (texture.position[1] + texture.size[1]) / m_texture_sizes[texture.texture_index][1];
-
-    VertexData vertices[4];
-    vertices[0] = { -half_width,      half_height,      0, 
-                    u1,               v2 };
-    vertices[1] = { -half_width,      -half_height,     0, 
-                    u1,               v1 };
-    vertices[2] = {  half_width,      half_height,      0, 
-                    u2,               v2 };
-    vertices[3] = {  half_width,      -half_height,     0, 
-                    u2,               v1 };
+    if(m_lights_valid && m_frame_lights.size() == m_light_grid.GetNumLights() &&
+       (m_frame_lights.empty() || memcmp(&m_frame_lights[0], m_light_grid.GetLights(), m_frame_lights.size() * sizeof(GridLight)) == 0))
+    {
+        return;
+    }
 
-    // Rotation
-    mat4x4 rotation_matrix;
-    mat4x4_identity(rotation_matrix);
-    mat4x4_rotate_Z(rotation_matrix, rotation_matrix, transform.rotation[2] * M_PI / 180.0);
-    mat4x4_rotate_Y(rotation_matrix, rotation_matrix, transform.rotation[1] * M_PI / 180.0);
-    mat4x4_rotate_X(rotation_matrix, rotation_matrix, transform.rotation[0] * M_PI / 180.0);
+    m_light_grid.Clear();
+    for(uint32_t i = 0; i < m_frame_lights.size(); i++)
+    {
+        const GridLight& grid_light = m_frame_lights[i];
+        m_light_grid.AddLight(grid_light.position, grid_light.radius, grid_light.color);
+    }
+    m_light_grid.Build();
+    m_lights_valid = true;
 
-    // Translation
-    mat4x4 translation_matrix;
-    mat4x4_identity(translation_matrix);
-    mat4x4_identity(translation_matrix);
-    mat4x4_translate(translation_matrix, transform.position[0], transform.position[1], transform.position[2]);
+    LightGridConstants light_grid_constants;
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        light_grid_constants.origin[i] = m_light_grid.GetOrigin()[i];
+        light_grid_constants.dimensions[i] = m_light_grid.GetDimensions()[i];
+    }
+    light_grid_constants.origin[3] = m_light_grid.GetCellSize();
+    light_grid_constants.dimensions[3] = 0;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_light_grid_constants_buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightGridConstants), &light_grid_constants);
+    UploadTextureBuffer(m_light_data_buffer, m_light_grid.GetNumLights() * sizeof(GridLight), m_light_grid.GetLights());
+    UploadTextureBuffer(m_light_cells_buffer, m_light_grid.GetNumCells() * sizeof(LightCellRange), m_light_grid.GetCellRanges());
+    UploadTextureBuffer(m_light_indices_buffer, m_light_grid.GetNumLightIndices() * sizeof(uint32_t), m_light_grid.GetLightIndices());
+    m_render_stats.gl_calls += 8;
+}
 
-    // Model Matrix
-    mat4x4 model_matrix;
-    mat4x4_mul(model_matrix, translation_matrix, rotation_matrix);
-                
-    // View Matrix
-    mat4x4 view_matrix;
-    mat4x4_look_at(view_matrix, m_eye, m_look, m_up);
-    
-    // Perspective Matrix
-    mat4x4 perspective_matrix;
-    if(m_zoom_on)
+// Texture buffers may not be empty, so keep at least one texel
+void RenderSystem::UploadTextureBuffer(uint32_t buffer, uint32_t size, const void* data)
+{
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    if(size == 0)
     {
-        mat4x4_perspective(perspective_matrix, 30 * M_PI / 180.0, 4 / 3, 0.1, 300);
+        glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STATIC_DRAW);
     }
     else
     {
-        mat4x4_perspective(perspective_matrix, 60 * M_PI / 180.0, 4 / 3, 0.1, 300);
+        glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STATIC_DRAW);
     }
+}
 
-    glBindTexture(GL_TEXTURE_2D, m_textures[texture.texture_index]);
+const RenderStats& RenderSystem::GetRenderStats()
+{
+    return m_render_stats;
+}
 
-    if(m_entity_manager->GetEntitySignature(entity_id) & XRAY_SYSTEM_SIGNATURE && m_xray_on)
+// Upload every quad of the frame into one vertex buffer and draw one range
+// per program and texture pair
+void RenderSystem::DrawQuadBatch()
+{
+    uint32_t num_quads = m_quad_batch.GetNumQuads();
+    if(num_quads == 0)
     {
-        glUseProgram(m_xray_program);
-        glUniformMatrix4fv(m_xray_m_location, 1, GL_FALSE, (const GLfloat*) model_matrix);
-        glUniformMatrix4fv(m_xray_v_location, 1, GL_FALSE, (const GLfloat*) view_matrix);
-        glUniformMatrix4fv(m_xray_p_location, 1, GL_FALSE, (const GLfloat*) perspective_matrix);
-        uint32_t use_light_location = glGetUniformLocation(m_xray_program, "use_light");
-        glUniform1ui(use_light_location, texture.use_light);
+        return;
     }
-    else
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+    m_render_stats.gl_calls += 2;
+
+    // The buffers only grow, so most frames reuse their storage
+    if(num_quads > m_batch_capacity)
+    {
+        uint32_t capacity = m_batch_capacity == 0 ? 256 : m_batch_capacity;
+        while(capacity < num_quads)
+        {
+            capacity *= 2;
+        }
+        m_batch_capacity = capacity;
+
+        std::vector<uint32_t> indices;
+        QuadBatch::BuildIndices(m_batch_capacity, indices);
+        glBufferData(GL_ARRAY_BUFFER, m_batch_capacity * 4 * sizeof(BatchVertex), NULL, GL_DYNAMIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), &indices[0], GL_STATIC_DRAW);
+        m_render_stats.gl_calls += 2;
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, num_quads * 4 * sizeof(BatchVertex), m_quad_batch.GetVertices());
+    m_render_stats.gl_calls++;
+
+    SetVertexLayout();
+
+    // Ranges are sorted by program and every texture is a layer of the bound
+    // array, so each run of ranges sharing a program is one draw
+    uint32_t current_program_index = invalid_program_index;
+    uint32_t first_quad = 0;
+    uint32_t num_run_quads = 0;
+    for(uint32_t i = 0; i < m_quad_batch.GetNumRanges(); i++)
     {
-        glUseProgram(m_shader_program);
-        glUniformMatrix4fv(m_m_location, 1, GL_FALSE, (const GLfloat*) model_matrix);
-        glUniformMatrix4fv(m_v_location, 1, GL_FALSE, (const GLfloat*) view_matrix);
-        glUniformMatrix4fv(m_p_location, 1, GL_FALSE, (const GLfloat*) perspective_matrix);
-        uint32_t use_light_location = glGetUniformLocation(m_shader_program, "use_light");
-        glUniform1ui(use_light_location, texture.use_light);
+        const QuadBatchRange& range = m_quad_batch.GetRange(i);
+        if(range.program_index != current_program_index)
+        {
+            DrawQuads(first_quad, num_run_quads);
+            glUseProgram(range.program_index == xray_program_index ? m_xray_program : m_shader_program);
+            current_program_index = range.program_index;
+            first_quad = range.first_quad;
+            num_run_quads = 0;
+            m_render_stats.gl_calls++;
+        }
+        num_run_quads += range.num_quads;
     }
+    DrawQuads(first_quad, num_run_quads);
+}
 
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_DYNAMIC_DRAW);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+// Keep the static groups whose bounds reach into the view
+void RenderSystem::CullStaticGeometry()
+{
+    m_visible_groups.clear();
+    for(uint32_t i = 0; i < m_static_geometry.GetNumGroups(); i++)
+    {
+        const StaticGeometryGroup& group = m_static_geometry.GetGroup(i);
+        if(m_frustum.IntersectsBox(group.min, group.max))
+        {
+            m_visible_groups.push_back(i);
+            m_render_stats.visible_quads += group.num_quads;
+        }
+        else
+        {
+            m_render_stats.culled_quads += group.num_quads;
+        }
+    }
 }
 
+// Draw the visible part of the baked level, picking the xray program for
+// xray groups while xray vision is on. Neighbouring visible groups that
+// share a program are one draw.
+void RenderSystem::DrawStaticGeometry()
+{
+    if(m_visible_groups.empty())
+    {
+        return;
+    }
 
-void RenderSystem::Update(float delta_time)
+    glBindBuffer(GL_ARRAY_BUFFER, m_static_vertex_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_static_index_buffer);
+    m_render_stats.gl_calls += 2;
+
+    SetVertexLayout();
+
+    uint32_t current_program_index = invalid_program_index;
+    uint32_t first_quad = 0;
+    uint32_t num_run_quads = 0;
+    for(uint32_t i = 0; i < m_visible_groups.size(); i++)
+    {
+        const StaticGeometryGroup& group = m_static_geometry.GetGroup(m_visible_groups[i]);
+        uint32_t program_index = group.xray && m_xray_on ? xray_program_index : quad_program_index;
+        if(program_index != current_program_index)
+        {
+            DrawQuads(first_quad, num_run_quads);
+            glUseProgram(program_index == xray_program_index ? m_xray_program : m_shader_program);
+            current_program_index = program_index;
+            first_quad = group.first_quad;
+            num_run_quads = 0;
+            m_render_stats.gl_calls++;
+        }
+        else if(group.first_quad != first_quad + num_run_quads)
+        {
+            DrawQuads(first_quad, num_run_quads);
+            first_quad = group.first_quad;
+            num_run_quads = 0;
+        }
+        num_run_quads += group.num_quads;
+    }
+    DrawQuads(first_quad, num_run_quads);
+}
+
+// Draw quads from the bound index buffer
+void RenderSystem::DrawQuads(uint32_t first_quad, uint32_t num_quads)
 {
-    uint32_t camera_entity_id = m_entity_manager->GetEntityId("player");
-    Transform& camera_transform = m_component_manager->GetComponent<Transform>(camera_entity_id);
+    if(num_quads == 0)
+    {
+        return;
+    }
+
+    glDrawElements(GL_TRIANGLES, num_quads * 6, GL_UNSIGNED_INT, (void*) (first_quad * 6 * sizeof(uint32_t)));
+    m_render_stats.gl_calls++;
+    m_render_stats.draw_calls++;
+}
 
-    m_eye[0] = camera_transform.position[0];
-    m_eye[1] = camera_transform.position[1];
-    m_eye[2] = camera_transform.position[2];
+// Point the attributes at BatchVertex data in the bound vertex buffer
+void RenderSystem::SetVertexLayout()
+{
+    glEnableVertexAttribArray(m_vpos_location);
+    glVertexAttribPointer(m_vpos_location, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(BatchVertex), (void*) 0);
+    glEnableVertexAttribArray(m_vtexcoord_location);
+    glVertexAttribPointer(m_vtexcoord_location, 2, GL_FLOAT, GL_FALSE,
+                          sizeof(BatchVertex), (void*) (sizeof(float) * 3));
+    glEnableVertexAttribArray(m_vuselight_location);
+    glVertexAttribPointer(m_vuselight_location, 1, GL_FLOAT, GL_FALSE,
+                          sizeof(BatchVertex), (void*) (sizeof(float) * 5));
+    glEnableVertexAttribArray(m_vlayer_location);
+    glVertexAttribPointer(m_vlayer_location, 1, GL_FLOAT, GL_FALSE,
+                          sizeof(BatchVertex), (void*) (sizeof(float) * 6));
+    m_render_stats.gl_calls += 8;
+}
 
+void RenderSystem::BuildModelMatrix(const Transform& transform, mat4x4 model_matrix)
+{
     // Rotation
     mat4x4 rotation_matrix;
     mat4x4_identity(rotation_matrix);
-    mat4x4_rotate_Z(rotation_matrix, rotation_matrix, camera_transform.rotation[2] * M_PI / 180.0);
-    mat4x4_rotate_Y(rotation_matrix, rotation_matrix, camera_transform.rotation[1] * M_PI / 180.0);
-    mat4x4_rotate_X(rotation_matrix, rotation_matrix, camera_transform.rotation[0] * M_PI / 180.0);
+    mat4x4_rotate_Z(rotation_matrix, rotation_matrix, transform.rotation[2] * M_PI / 180.0);
+    mat4x4_rotate_Y(rotation_matrix, rotation_matrix, transform.rotation[1] * M_PI / 180.0);
+    mat4x4_rotate_X(rotation_matrix, rotation_matrix, transform.rotation[0] * M_PI / 180.0);
 
-    vec4 forward = { 0, 0, -1 , 0};
-    vec4 result;
+    // Translation
+    mat4x4 translation_matrix;
+    mat4x4_identity(translation_matrix);
+    mat4x4_translate(translation_matrix, transform.position[0], transform.position[1], transform.position[2]);
 
-    mat4x4_mul_vec4(result, rotation_matrix, forward);
+    mat4x4_mul(model_matrix, translation_matrix, rotation_matrix);
+}
 
-    m_look[0] = m_eye[0] + result[0];
-    m_look[1] = m_eye[1] + result[1];
-    m_look[2] = m_eye[2] + result[2];
- 
-    int32_t vpos_location = glGetAttribLocation(m_shader_program, "vPos");
-    int32_t vtexcoord_location = glGetAttribLocation(m_shader_program, "vTexCoord");
- 
-    glEnableVertexAttribArray(vpos_location);
-    glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE,
-                          sizeof(VertexData), (void*) 0);
-    glEnableVertexAttribArray(vtexcoord_location);
-    glVertexAttribPointer(vtexcoord_location, 2, GL_FLOAT, GL_FALSE,
-                          sizeof(VertexData), (void*) (sizeof(float) * 3));
-
-    uint32_t num_entities = m_entity_manager->GetNumEntities();
-    
-    for(uint32_t i = 0; i < num_entities; i++)
+// u1, v1, u2, v2 of the texture's region. Layers hold their image tiled,
+// so texel positions map straight onto the layer.
+void RenderSystem::GetTextureCoordinates(const Texture& texture, float texture_coordinates[4])
+{
+    texture_coordinates[0] = texture.position[0] / texture_layer_size;
+    texture_coordinates[1] = texture.position[1] / texture_layer_size;
+    texture_coordinates[2] = (texture.position[0] + texture.size[0]) / texture_layer_size;
+    texture_coordinates[3] = (texture.position[1] + texture.size[1]) / texture_layer_size;
+}
+
+void RenderSystem::SetInterpolationAlpha(float alpha)
+{
+    m_interpolation_alpha = alpha;
+}
+
+// Physics runs on a fixed step, so blend between the last two simulated
+// positions to draw moving bodies where they are at this point in the frame
+void RenderSystem::GetRenderPosition(uint32_t entity_id, vec3 position)
+{
+    Transform& transform = m_component_manager->GetComponent<Transform>(entity_id);
+    if(!(m_entity_manager->GetEntitySignature(entity_id) & PHYSICS_SYSTEM_SIGNATURE))
     {
-        if(m_entity_manager->GetEntityState(i) == EntityState::ACTIVE &&
-            (m_entity_manager->GetEntitySignature(i) & m_system_signature))
-        {
-            HandleEntity(i, delta_time);
-        }
+        position[0] = transform.position[0];
+        position[1] = transform.position[1];
+        position[2] = transform.position[2];
+        return;
+    }
+
+    RigidBody& rigid_body = m_component_manager->GetComponent<RigidBody>(entity_id);
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        position[i] = rigid_body.previous_position[i] + (transform.position[i] - rigid_body.previous_position[i]) * m_interpolation_alpha;
     }
 }
\ No newline at end of file
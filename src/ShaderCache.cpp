@@ -0,0 +1,399 @@
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include <glad/gl.h>
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include "ShaderCache.hpp"
+
+// Program binaries are core in GL 4.1 and otherwise come with
+// ARB_get_program_binary, neither of which the loader was generated for
+namespace
+{
+    const GLenum program_binary_retrievable_hint = 0x8257;
+    const GLenum program_binary_length = 0x8741;
+    const GLenum num_program_binary_formats = 0x87FE;
+
+    typedef void (GLAD_API_PTR *GetProgramBinaryFunction)(GLuint program, GLsizei buf_size, GLsizei* length, GLenum* binary_format, void* binary);
+    typedef void (GLAD_API_PTR *ProgramBinaryFunction)(GLuint program, GLenum binary_format, const void* binary, GLsizei length);
+    typedef void (GLAD_API_PTR *ProgramParameteriFunction)(GLuint program, GLenum pname, GLint value);
+
+    GetProgramBinaryFunction get_program_binary = NULL;
+    ProgramBinaryFunction program_binary = NULL;
+    ProgramParameteriFunction program_parameteri = NULL;
+
+    const uint32_t binary_file_magic = 0x42534758; // XGSB
+
+    struct BinaryFileHeader
+    {
+        uint32_t magic;
+        uint32_t binary_format;
+        uint32_t length;
+    };
+
+    // FNV-1a
+    uint64_t HashString(uint64_t hash, const char* string)
+    {
+        if(string == NULL)
+        {
+            return hash;
+        }
+        for(const char* c = string; *c != '\0'; c++)
+        {
+            hash ^= (unsigned char)*c;
+            hash *= 0x100000001B3ull;
+        }
+        // Separator so "ab" + "c" and "a" + "bc" differ
+        hash ^= 0xFF;
+        hash *= 0x100000001B3ull;
+        return hash;
+    }
+
+    const uint64_t hash_seed = 0xCBF29CE484222325ull;
+}
+
+ShaderCache::ShaderCache(const char* cache_directory) :
+    m_cache_directory(cache_directory),
+    m_binaries_supported(false),
+    m_driver_hash(hash_seed)
+{
+    memset(&m_stats, 0, sizeof(ShaderCacheStats));
+
+    // Binaries only load on the driver that wrote them, so keep them apart
+    m_driver_hash = HashString(m_driver_hash, (const char*)glGetString(GL_VENDOR));
+    m_driver_hash = HashString(m_driver_hash, (const char*)glGetString(GL_RENDERER));
+    m_driver_hash = HashString(m_driver_hash, (const char*)glGetString(GL_VERSION));
+
+    if(glfwExtensionSupported("GL_ARB_get_program_binary"))
+    {
+        get_program_binary = (GetProgramBinaryFunction)glfwGetProcAddress("glGetProgramBinary");
+        program_binary = (ProgramBinaryFunction)glfwGetProcAddress("glProgramBinary");
+        program_parameteri = (ProgramParameteriFunction)glfwGetProcAddress("glProgramParameteri");
+    }
+
+    GLint num_formats = 0;
+    if(get_program_binary != NULL && program_binary != NULL && program_parameteri != NULL)
+    {
+        glGetIntegerv(num_program_binary_formats, &num_formats);
+    }
+    m_binaries_supported = num_formats > 0;
+    if(!m_binaries_supported)
+    {
+        printf("Program binaries not supported, shaders will be compiled on every start\n");
+        return;
+    }
+
+#ifdef _WIN32
+    _mkdir(m_cache_directory.c_str());
+#else
+    mkdir(m_cache_directory.c_str(), 0755);
+#endif
+}
+
+ShaderCache::~ShaderCache()
+{
+    for(uint32_t i = 0; i < m_programs.size(); i++)
+    {
+        glDeleteProgram(m_programs[i].program);
+    }
+}
+
+uint32_t ShaderCache::GetProgram(const char* vertex_source, const char* fragment_source)
+{
+    std::chrono::time_point<std::chrono::steady_clock> start_time = std::chrono::steady_clock::now();
+
+    uint64_t hash = HashString(HashString(hash_seed, vertex_source), fragment_source);
+    for(uint32_t i = 0; i < m_programs.size(); i++)
+    {
+        if(m_programs[i].hash == hash)
+        {
+            m_stats.programs_reused++;
+            return m_programs[i].program;
+        }
+    }
+
+    uint32_t program = LoadProgramBinary(hash);
+    if(program != 0)
+    {
+        m_stats.programs_loaded++;
+    }
+    else
+    {
+        program = CompileProgram(vertex_source, fragment_source);
+        if(program == 0)
+        {
+            return 0;
+        }
+        m_stats.programs_compiled++;
+        SaveProgramBinary(hash, program);
+    }
+
+    CachedProgram cached_program;
+    cached_program.hash = hash;
+    cached_program.program = program;
+    ReflectProgram(cached_program);
+    m_programs.push_back(cached_program);
+
+    std::chrono::time_point<std::chrono::steady_clock> end_time = std::chrono::steady_clock::now();
+    m_stats.milliseconds += std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count() / 1000.0;
+
+    return program;
+}
+
+int32_t ShaderCache::GetUniformLocation(uint32_t program, const char* name)
+{
+    CachedProgram* cached_program = FindProgram(program);
+    if(cached_program == NULL)
+    {
+        return -1;
+    }
+
+    std::map<std::string, int32_t>::iterator it = cached_program->uniform_locations.find(name);
+    return it == cached_program->uniform_locations.end() ? -1 : it->second;
+}
+
+int32_t ShaderCache::GetAttribLocation(uint32_t program, const char* name)
+{
+    CachedProgram* cached_program = FindProgram(program);
+    if(cached_program == NULL)
+    {
+        return -1;
+    }
+
+    std::map<std::string, int32_t>::iterator it = cached_program->attrib_locations.find(name);
+    return it == cached_program->attrib_locations.end() ? -1 : it->second;
+}
+
+const ShaderCacheStats& ShaderCache::GetStats()
+{
+    return m_stats;
+}
+
+uint32_t ShaderCache::CompileProgram(const char* vertex_source, const char* fragment_source)
+{
+    uint32_t vertex_shader = CompileShader(GL_VERTEX_SHADER, vertex_source);
+    if(vertex_shader == 0)
+    {
+        return 0;
+    }
+
+    uint32_t fragment_shader = CompileShader(GL_FRAGMENT_SHADER, fragment_source);
+    if(fragment_shader == 0)
+    {
+        glDeleteShader(vertex_shader);
+        return 0;
+    }
+
+    uint32_t program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    if(m_binaries_supported)
+    {
+        program_parameteri(program, program_binary_retrievable_hint, GL_TRUE);
+    }
+    glLinkProgram(program);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if(status == GL_FALSE)
+    {
+        GLint maxLength = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
+
+        // The maxLength includes the NULL character
+        std::vector<GLchar> errorLog(maxLength + 1);
+        glGetProgramInfoLog(program, maxLength, &maxLength, &errorLog[0]);
+        printf("%s\n", errorLog.data());
+
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+uint32_t ShaderCache::CompileShader(uint32_t type, const char* source)
+{
+    uint32_t shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint isCompiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
+    if(isCompiled == GL_FALSE)
+    {
+        GLint maxLength = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &maxLength);
+
+        // The maxLength includes the NULL character
+        std::vector<GLchar> errorLog(maxLength + 1);
+        glGetShaderInfoLog(shader, maxLength, &maxLength, &errorLog[0]);
+        printf("%s\n", errorLog.data());
+
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+uint32_t ShaderCache::LoadProgramBinary(uint64_t hash)
+{
+    if(!m_binaries_supported)
+    {
+        return 0;
+    }
+
+    std::string path;
+    GetBinaryPath(hash, path);
+    FILE* file = fopen(path.c_str(), "rb");
+    if(file == NULL)
+    {
+        return 0;
+    }
+
+    // The length is checked against the file before allocating, so a
+    // damaged header falls back to compiling instead of a huge allocation
+    long file_size = -1;
+    if(fseek(file, 0, SEEK_END) == 0)
+    {
+        file_size = ftell(file);
+    }
+    rewind(file);
+
+    BinaryFileHeader header;
+    std::vector<char> binary;
+    bool valid = file_size >= (long)sizeof(BinaryFileHeader) &&
+                 fread(&header, sizeof(BinaryFileHeader), 1, file) == 1 &&
+                 header.magic == binary_file_magic && header.length > 0 &&
+                 header.length == (uint64_t)file_size - sizeof(BinaryFileHeader);
+    if(valid)
+    {
+        binary.resize(header.length);
+        valid = fread(&binary[0], 1, header.length, file) == header.length;
+    }
+    fclose(file);
+    if(!valid)
+    {
+        printf("Ignoring damaged program binary %s\n", path.c_str());
+        return 0;
+    }
+
+    uint32_t program = glCreateProgram();
+    program_binary(program, header.binary_format, &binary[0], header.length);
+
+    // Drivers reject binaries from other versions of themselves
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if(status == GL_FALSE)
+    {
+        printf("Program binary %s was rejected, compiling instead\n", path.c_str());
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+void ShaderCache::SaveProgramBinary(uint64_t hash, uint32_t program)
+{
+    if(!m_binaries_supported)
+    {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, program_binary_length, &length);
+    if(length <= 0)
+    {
+        return;
+    }
+
+    BinaryFileHeader header;
+    std::vector<char> binary(length);
+    GLsizei written_length = 0;
+    GLenum binary_format = 0;
+    get_program_binary(program, length, &written_length, &binary_format, &binary[0]);
+    if(written_length <= 0)
+    {
+        return;
+    }
+    header.magic = binary_file_magic;
+    header.binary_format = binary_format;
+    header.length = written_length;
+
+    std::string path;
+    GetBinaryPath(hash, path);
+    FILE* file = fopen(path.c_str(), "wb");
+    if(file == NULL)
+    {
+        printf("Unable to write program binary %s\n", path.c_str());
+        return;
+    }
+    bool written = fwrite(&header, sizeof(BinaryFileHeader), 1, file) == 1 &&
+                   fwrite(&binary[0], 1, written_length, file) == (size_t)written_length;
+    written = fclose(file) == 0 && written;
+
+    // A partial binary would only be rejected on the next load, so drop it
+    if(!written)
+    {
+        printf("Unable to write program binary %s\n", path.c_str());
+        remove(path.c_str());
+    }
+}
+
+void ShaderCache::GetBinaryPath(uint64_t hash, std::string& path)
+{
+    char file_name[64];
+    snprintf(file_name, sizeof(file_name), "/%016llx_%016llx.bin",
+             (unsigned long long)m_driver_hash, (unsigned long long)hash);
+    path = m_cache_directory + file_name;
+}
+
+void ShaderCache::ReflectProgram(CachedProgram& cached_program)
+{
+    GLchar name[256];
+    GLsizei name_length;
+    GLint size;
+    GLenum type;
+
+    GLint num_uniforms = 0;
+    glGetProgramiv(cached_program.program, GL_ACTIVE_UNIFORMS, &num_uniforms);
+    for(GLint i = 0; i < num_uniforms; i++)
+    {
+        glGetActiveUniform(cached_program.program, i, sizeof(name), &name_length, &size, &type, name);
+        int32_t location = glGetUniformLocation(cached_program.program, name);
+        if(location >= 0)
+        {
+            cached_program.uniform_locations[name] = location;
+        }
+    }
+
+    GLint num_attribs = 0;
+    glGetProgramiv(cached_program.program, GL_ACTIVE_ATTRIBUTES, &num_attribs);
+    for(GLint i = 0; i < num_attribs; i++)
+    {
+        glGetActiveAttrib(cached_program.program, i, sizeof(name), &name_length, &size, &type, name);
+        cached_program.attrib_locations[name] = glGetAttribLocation(cached_program.program, name);
+    }
+}
+
+ShaderCache::CachedProgram* ShaderCache::FindProgram(uint32_t program)
+{
+    for(uint32_t i = 0; i < m_programs.size(); i++)
+    {
+        if(m_programs[i].program == program)
+        {
+            return &m_programs[i];
+        }
+    }
+    return NULL;
+}
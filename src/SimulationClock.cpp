@@ -0,0 +1,56 @@
+#include "SimulationClock.hpp"
+
+SimulationClock::SimulationClock(uint32_t steps_per_second, uint32_t max_steps_per_frame) :
+    m_step_nanoseconds(1000000000ull / (steps_per_second > 0 ? steps_per_second : 1)),
+    m_max_steps_per_frame(max_steps_per_frame > 0 ? max_steps_per_frame : 1),
+    m_accumulator(0),
+    m_num_frame_steps(0),
+    m_num_dropped_steps(0)
+{
+
+}
+
+SimulationClock::~SimulationClock()
+{
+
+}
+
+void SimulationClock::Advance(uint64_t elapsed_nanoseconds)
+{
+    m_accumulator += elapsed_nanoseconds;
+    m_num_frame_steps = 0;
+
+    uint64_t max_accumulator = m_step_nanoseconds * m_max_steps_per_frame;
+    if(m_accumulator > max_accumulator)
+    {
+        m_num_dropped_steps += (m_accumulator - max_accumulator) / m_step_nanoseconds;
+        m_accumulator = max_accumulator;
+    }
+}
+
+bool SimulationClock::Step()
+{
+    if(m_accumulator < m_step_nanoseconds || m_num_frame_steps >= m_max_steps_per_frame)
+    {
+        return false;
+    }
+
+    m_accumulator -= m_step_nanoseconds;
+    m_num_frame_steps++;
+    return true;
+}
+
+float SimulationClock::GetStepTime()
+{
+    return m_step_nanoseconds * 1e-9;
+}
+
+float SimulationClock::GetAlpha()
+{
+    return (float)m_accumulator / (float)m_step_nanoseconds;
+}
+
+uint64_t SimulationClock::GetNumDroppedSteps()
+{
+    return m_num_dropped_steps;
+}
@@ -0,0 +1,219 @@
+#include <cmath>
+#include <cstring>
+
+#include "SpatialHash.hpp"
+
+SpatialHash::SpatialHash(uint32_t max_num_items, float cell_size) :
+    m_max_num_items(max_num_items),
+    m_cell_size(cell_size),
+    m_max_cells_per_item(64),
+    m_num_items(0),
+    m_item_ids(new uint32_t[max_num_items]),
+    m_item_bounds(new float[max_num_items * 6]),
+    m_item_stamps(new uint32_t[max_num_items]),
+    m_query_stamp(0)
+{
+    uint32_t num_buckets = 16;
+    while(num_buckets < max_num_items * 2)
+    {
+        num_buckets *= 2;
+    }
+    m_bucket_mask = num_buckets - 1;
+    m_bucket_starts = new uint32_t[num_buckets + 1];
+    memset(m_bucket_starts, 0, (num_buckets + 1) * sizeof(uint32_t));
+    memset(m_item_stamps, 0, max_num_items * sizeof(uint32_t));
+}
+
+SpatialHash::~SpatialHash()
+{
+    delete[] m_item_ids;
+    delete[] m_item_bounds;
+    delete[] m_item_stamps;
+    delete[] m_bucket_starts;
+}
+
+void SpatialHash::Clear()
+{
+    m_num_items = 0;
+    m_bucket_items.clear();
+    m_oversized_items.clear();
+}
+
+void SpatialHash::Insert(uint32_t item_id, const vec3 min, const vec3 max)
+{
+    if(m_num_items >= m_max_num_items)
+    {
+        return;
+    }
+
+    float* bounds = &m_item_bounds[m_num_items * 6];
+    bounds[0] = min[0];
+    bounds[1] = min[1];
+    bounds[2] = min[2];
+    bounds[3] = max[0];
+    bounds[4] = max[1];
+    bounds[5] = max[2];
+    m_item_ids[m_num_items] = item_id;
+    m_num_items++;
+}
+
+void SpatialHash::Build()
+{
+    uint32_t num_buckets = m_bucket_mask + 1;
+    memset(m_bucket_starts, 0, (num_buckets + 1) * sizeof(uint32_t));
+    m_oversized_items.clear();
+
+    // Count entries per bucket, then prefix sum into start offsets
+    for(uint32_t i = 0; i < m_num_items; i++)
+    {
+        int32_t cell_min[3];
+        int32_t cell_max[3];
+        if(!GetCellRange(&m_item_bounds[i * 6], &m_item_bounds[i * 6 + 3], cell_min, cell_max))
+        {
+            m_oversized_items.push_back(i);
+            continue;
+        }
+        for(int32_t x = cell_min[0]; x <= cell_max[0]; x++)
+        {
+            for(int32_t y = cell_min[1]; y <= cell_max[1]; y++)
+            {
+                for(int32_t z = cell_min[2]; z <= cell_max[2]; z++)
+                {
+                    m_bucket_starts[GetBucket(x, y, z) + 1]++;
+                }
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < num_buckets; i++)
+    {
+        m_bucket_starts[i + 1] += m_bucket_starts[i];
+    }
+    m_bucket_items.resize(m_bucket_starts[num_buckets]);
+
+    // Fill using the start offsets as write cursors, then shift them back
+    for(uint32_t i = 0; i < m_num_items; i++)
+    {
+        int32_t cell_min[3];
+        int32_t cell_max[3];
+        if(!GetCellRange(&m_item_bounds[i * 6], &m_item_bounds[i * 6 + 3], cell_min, cell_max))
+        {
+            continue;
+        }
+        for(int32_t x = cell_min[0]; x <= cell_max[0]; x++)
+        {
+            for(int32_t y = cell_min[1]; y <= cell_max[1]; y++)
+            {
+                for(int32_t z = cell_min[2]; z <= cell_max[2]; z++)
+                {
+                    m_bucket_items[m_bucket_starts[GetBucket(x, y, z)]++] = i;
+                }
+            }
+        }
+    }
+
+    for(uint32_t i = num_buckets; i > 0; i--)
+    {
+        m_bucket_starts[i] = m_bucket_starts[i - 1];
+    }
+    m_bucket_starts[0] = 0;
+}
+
+uint32_t SpatialHash::Query(const vec3 min, const vec3 max)
+{
+    m_candidates.clear();
+
+    m_query_stamp++;
+    if(m_query_stamp == 0)
+    {
+        memset(m_item_stamps, 0, m_max_num_items * sizeof(uint32_t));
+        m_query_stamp = 1;
+    }
+
+    int32_t cell_min[3];
+    int32_t cell_max[3];
+    if(GetCellRange(min, max, cell_min, cell_max))
+    {
+        for(int32_t x = cell_min[0]; x <= cell_max[0]; x++)
+        {
+            for(int32_t y = cell_min[1]; y <= cell_max[1]; y++)
+            {
+                for(int32_t z = cell_min[2]; z <= cell_max[2]; z++)
+                {
+                    uint32_t bucket = GetBucket(x, y, z);
+                    for(uint32_t i = m_bucket_starts[bucket]; i < m_bucket_starts[bucket + 1]; i++)
+                    {
+                        AddCandidate(m_bucket_items[i], min, max);
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        // Query box is too large to walk cell by cell
+        for(uint32_t i = 0; i < m_num_items; i++)
+        {
+            AddCandidate(i, min, max);
+        }
+    }
+
+    for(uint32_t i = 0; i < m_oversized_items.size(); i++)
+    {
+        AddCandidate(m_oversized_items[i], min, max);
+    }
+
+    return m_candidates.size();
+}
+
+uint32_t* SpatialHash::GetCandidates()
+{
+    return m_candidates.empty() ? NULL : &m_candidates[0];
+}
+
+uint32_t SpatialHash::GetMaxNumItems()
+{
+    return m_max_num_items;
+}
+
+bool SpatialHash::GetCellRange(const float* min, const float* max, int32_t* cell_min, int32_t* cell_max)
+{
+    uint32_t num_cells = 1;
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        float cell_min_f = floorf(min[i] / m_cell_size);
+        float cell_max_f = floorf(max[i] / m_cell_size);
+        float span = cell_max_f - cell_min_f + 1;
+        if(!(span <= m_max_cells_per_item))
+        {
+            return false;
+        }
+        cell_min[i] = (int32_t)cell_min_f;
+        cell_max[i] = (int32_t)cell_max_f;
+        num_cells *= cell_max[i] - cell_min[i] + 1;
+    }
+    return num_cells <= m_max_cells_per_item;
+}
+
+uint32_t SpatialHash::GetBucket(int32_t x, int32_t y, int32_t z)
+{
+    uint32_t hash = ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u) ^ ((uint32_t)z * 83492791u);
+    return hash & m_bucket_mask;
+}
+
+void SpatialHash::AddCandidate(uint32_t item_index, const float* min, const float* max)
+{
+    if(m_item_stamps[item_index] == m_query_stamp)
+    {
+        return;
+    }
+    m_item_stamps[item_index] = m_query_stamp;
+
+    const float* bounds = &m_item_bounds[item_index * 6];
+    if(bounds[3] >= min[0] && max[0] >= bounds[0] &&
+       bounds[4] >= min[1] && max[1] >= bounds[1] &&
+       bounds[5] >= min[2] && max[2] >= bounds[2])
+    {
+        m_candidates.push_back(m_item_ids[item_index]);
+    }
+}
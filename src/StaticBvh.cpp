@@ -0,0 +1,190 @@
+#include <algorithm>
+
+#include "StaticBvh.hpp"
+
+const uint32_t max_items_per_leaf = 4;
+
+namespace
+{
+    struct CentroidLess
+    {
+        const float* bounds;
+        uint32_t axis;
+
+        bool operator()(uint32_t a, uint32_t b) const
+        {
+            return bounds[a * 6 + axis] + bounds[a * 6 + 3 + axis] < bounds[b * 6 + axis] + bounds[b * 6 + 3 + axis];
+        }
+    };
+}
+
+StaticBvh::StaticBvh()
+{
+
+}
+
+StaticBvh::~StaticBvh()
+{
+
+}
+
+void StaticBvh::Clear()
+{
+    m_item_ids.clear();
+    m_item_bounds.clear();
+    m_item_order.clear();
+    m_nodes.clear();
+}
+
+void StaticBvh::Insert(uint32_t item_id, const vec3 min, const vec3 max)
+{
+    m_item_ids.push_back(item_id);
+    m_item_bounds.push_back(min[0]);
+    m_item_bounds.push_back(min[1]);
+    m_item_bounds.push_back(min[2]);
+    m_item_bounds.push_back(max[0]);
+    m_item_bounds.push_back(max[1]);
+    m_item_bounds.push_back(max[2]);
+}
+
+void StaticBvh::Build()
+{
+    uint32_t num_items = m_item_ids.size();
+    m_item_order.resize(num_items);
+    for(uint32_t i = 0; i < num_items; i++)
+    {
+        m_item_order[i] = i;
+    }
+
+    m_nodes.clear();
+    if(num_items > 0)
+    {
+        m_nodes.reserve(num_items * 2);
+        BuildNode(0, num_items);
+    }
+}
+
+// Median split along the longest axis of the centroid bounds
+uint32_t StaticBvh::BuildNode(uint32_t first_item, uint32_t num_items)
+{
+    uint32_t node_index = m_nodes.size();
+    m_nodes.push_back(Node());
+
+    float bounds[6];
+    float centroid_bounds[6];
+    for(uint32_t j = 0; j < 3; j++)
+    {
+        bounds[j] = centroid_bounds[j] = 3.4e38f;
+        bounds[j + 3] = centroid_bounds[j + 3] = -3.4e38f;
+    }
+    for(uint32_t i = first_item; i < first_item + num_items; i++)
+    {
+        const float* item_bounds = &m_item_bounds[m_item_order[i] * 6];
+        for(uint32_t j = 0; j < 3; j++)
+        {
+            float centroid = (item_bounds[j] + item_bounds[j + 3]) / 2;
+            bounds[j] = std::min(bounds[j], item_bounds[j]);
+            bounds[j + 3] = std::max(bounds[j + 3], item_bounds[j + 3]);
+            centroid_bounds[j] = std::min(centroid_bounds[j], centroid);
+            centroid_bounds[j + 3] = std::max(centroid_bounds[j + 3], centroid);
+        }
+    }
+
+    Node node;
+    std::copy(bounds, bounds + 6, node.bounds);
+    node.right_child = 0;
+    node.first_item = first_item;
+    node.num_items = num_items;
+
+    if(num_items > max_items_per_leaf)
+    {
+        uint32_t axis = 0;
+        for(uint32_t j = 1; j < 3; j++)
+        {
+            if(centroid_bounds[j + 3] - centroid_bounds[j] > centroid_bounds[axis + 3] - centroid_bounds[axis])
+            {
+                axis = j;
+            }
+        }
+
+        CentroidLess less = { &m_item_bounds[0], axis };
+        uint32_t num_left = num_items / 2;
+        std::nth_element(m_item_order.begin() + first_item,
+                         m_item_order.begin() + first_item + num_left,
+                         m_item_order.begin() + first_item + num_items,
+                         less);
+
+        node.num_items = 0;
+        BuildNode(first_item, num_left);
+        node.right_child = BuildNode(first_item + num_left, num_items - num_left);
+    }
+
+    m_nodes[node_index] = node;
+    return node_index;
+}
+
+uint32_t StaticBvh::Query(const vec3 min, const vec3 max)
+{
+    m_results.clear();
+    if(m_nodes.empty())
+    {
+        return 0;
+    }
+
+    m_stack.clear();
+    m_stack.push_back(0);
+    while(!m_stack.empty())
+    {
+        uint32_t node_index = m_stack.back();
+        m_stack.pop_back();
+        const Node& node = m_nodes[node_index];
+
+        if(!(node.bounds[3] >= min[0] && max[0] >= node.bounds[0] &&
+             node.bounds[4] >= min[1] && max[1] >= node.bounds[1] &&
+             node.bounds[5] >= min[2] && max[2] >= node.bounds[2]))
+        {
+            continue;
+        }
+
+        if(node.num_items == 0)
+        {
+            m_stack.push_back(node.right_child);
+            m_stack.push_back(node_index + 1);
+            continue;
+        }
+
+        for(uint32_t i = node.first_item; i < node.first_item + node.num_items; i++)
+        {
+            uint32_t item_index = m_item_order[i];
+            const float* bounds = &m_item_bounds[item_index * 6];
+            if(bounds[3] >= min[0] && max[0] >= bounds[0] &&
+               bounds[4] >= min[1] && max[1] >= bounds[1] &&
+               bounds[5] >= min[2] && max[2] >= bounds[2])
+            {
+                m_results.push_back(item_index);
+            }
+        }
+    }
+
+    return m_results.size();
+}
+
+uint32_t* StaticBvh::GetResults()
+{
+    return m_results.empty() ? NULL : &m_results[0];
+}
+
+uint32_t StaticBvh::GetNumItems()
+{
+    return m_item_ids.size();
+}
+
+uint32_t StaticBvh::GetItemId(uint32_t index)
+{
+    return m_item_ids[index];
+}
+
+const float* StaticBvh::GetItemBounds(uint32_t index)
+{
+    return &m_item_bounds[index * 6];
+}
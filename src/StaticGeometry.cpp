@@ -0,0 +1,136 @@
+#include <cmath>
+#include <algorithm>
+
+#include "StaticGeometry.hpp"
+
+namespace
+{
+    const uint32_t use_light_flag = 0x1;
+    const uint32_t xray_flag = 0x2;
+    const uint32_t group_flags_shift = 24;
+    const uint32_t chunk_index_mask = 0x00FFFFFF;
+    const uint32_t oversized_chunk_index = 0;
+}
+
+StaticGeometry::StaticGeometry(float chunk_size) :
+    m_chunk_size(chunk_size)
+{
+
+}
+
+StaticGeometry::~StaticGeometry()
+{
+
+}
+
+void StaticGeometry::Clear()
+{
+    m_quads.Clear();
+    m_groups.clear();
+    m_chunk_indices.clear();
+}
+
+void StaticGeometry::AddQuad(uint32_t texture_index, bool use_light, bool xray, mat4x4 model_matrix,
+                             float half_width, float half_height, float u1, float v1, float u2, float v2)
+{
+    uint32_t group_flags = 0;
+    if(use_light)
+    {
+        group_flags |= use_light_flag;
+    }
+    if(xray)
+    {
+        group_flags |= xray_flag;
+    }
+
+    // The model matrix translation is the center of the quad
+    uint32_t chunk_index = oversized_chunk_index;
+    if(std::max(half_width, half_height) * 2 <= m_chunk_size)
+    {
+        uint64_t chunk_key = 0;
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            int32_t cell = floorf(model_matrix[3][i] / m_chunk_size);
+            chunk_key = (chunk_key << 21) | ((uint64_t)cell & 0x1FFFFF);
+        }
+
+        std::map<uint64_t, uint32_t>::iterator it = m_chunk_indices.find(chunk_key);
+        if(it == m_chunk_indices.end())
+        {
+            chunk_index = m_chunk_indices.size() + 1;
+            m_chunk_indices[chunk_key] = chunk_index;
+        }
+        else
+        {
+            chunk_index = it->second;
+        }
+    }
+
+    m_quads.AddQuad((group_flags << group_flags_shift) | chunk_index, texture_index, model_matrix,
+                    half_width, half_height, u1, v1, u2, v2, use_light);
+}
+
+void StaticGeometry::Build()
+{
+    m_quads.Build();
+
+    const BatchVertex* vertices = m_quads.GetVertices();
+    m_groups.resize(m_quads.GetNumRanges());
+    for(uint32_t i = 0; i < m_groups.size(); i++)
+    {
+        const QuadBatchRange& range = m_quads.GetRange(i);
+        uint32_t group_flags = range.program_index >> group_flags_shift;
+        StaticGeometryGroup& group = m_groups[i];
+        group.texture_index = range.texture_index;
+        group.use_light = group_flags & use_light_flag;
+        group.xray = group_flags & xray_flag;
+        group.chunk_index = range.program_index & chunk_index_mask;
+        group.first_quad = range.first_quad;
+        group.num_quads = range.num_quads;
+
+        const BatchVertex* vertex = &vertices[range.first_quad * 4];
+        const BatchVertex* last_vertex = vertex + range.num_quads * 4;
+        group.min[0] = group.max[0] = vertex->x;
+        group.min[1] = group.max[1] = vertex->y;
+        group.min[2] = group.max[2] = vertex->z;
+        for(; vertex != last_vertex; vertex++)
+        {
+            group.min[0] = std::min(group.min[0], vertex->x);
+            group.min[1] = std::min(group.min[1], vertex->y);
+            group.min[2] = std::min(group.min[2], vertex->z);
+            group.max[0] = std::max(group.max[0], vertex->x);
+            group.max[1] = std::max(group.max[1], vertex->y);
+            group.max[2] = std::max(group.max[2], vertex->z);
+        }
+    }
+}
+
+uint32_t StaticGeometry::GetNumQuads()
+{
+    return m_quads.GetNumQuads();
+}
+
+uint32_t StaticGeometry::GetNumVertices()
+{
+    return m_quads.GetNumQuads() * 4;
+}
+
+uint32_t StaticGeometry::GetNumChunks()
+{
+    return m_chunk_indices.size() + 1;
+}
+
+uint32_t StaticGeometry::GetNumGroups()
+{
+    return m_groups.size();
+}
+
+const StaticGeometryGroup& StaticGeometry::GetGroup(uint32_t index)
+{
+    return m_groups[index];
+}
+
+const BatchVertex* StaticGeometry::GetVertices()
+{
+    return m_quads.GetVertices();
+}
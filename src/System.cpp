@@ -1,14 +1,16 @@
 #include "System.hpp"
 
 
-System::System(MessageBus& message_bus, uint32_t system_signature) : m_message_bus(message_bus), m_system_signature(system_signature)
+System::System(MessageBus& message_bus, uint32_t system_signature) : m_message_bus(message_bus), m_system_signature(system_signature), m_query_id(invalid_query_id),
+    m_read_access(ALL_ACCESS), m_write_access(ALL_ACCESS), m_chunkable(false)
 {
-    message_bus.RegisterSystem(this);
+
 }
 
 void System::SetEntityManager(EntityManager* entity_manager)
 {
     m_entity_manager = entity_manager;
+    m_query_id = m_entity_manager->RegisterQuery(m_system_signature);
 }
 
 void System::SetComponentManager(ComponentManager* component_manager)
@@ -16,16 +18,83 @@ void System::SetComponentManager(ComponentManager* component_manager)
     m_component_manager = component_manager;
 }
 
+// HandleEntity may create or destroy entities, which changes the query
+// under the loop, so walk a copy of it taken up front. Entities that leave
+// the query meanwhile are skipped, and ones that join it wait for the next
+// update.
 void System::Update(float delta_time)
 {
-    uint32_t num_entities = m_entity_manager->GetNumEntities();
-    
+    uint32_t num_entities = m_entity_manager->GetQuerySize(m_query_id);
+    uint32_t* entities = m_entity_manager->GetQueryEntities(m_query_id);
+    m_update_entities.resize(num_entities);
+    for(uint32_t i = 0; i < num_entities; i++)
+    {
+        m_update_entities[i] = m_entity_manager->GetEntityHandle(entities[i]);
+    }
+
     for(uint32_t i = 0; i < num_entities; i++)
     {
-        if(m_entity_manager->GetEntityState(i) == EntityState::ACTIVE &&
-            (m_entity_manager->GetEntitySignature(i) & m_system_signature))
+        EntityHandle handle = m_update_entities[i];
+        uint32_t entity_id = GetEntityIndex(handle);
+        if(!m_entity_manager->IsAlive(handle) ||
+           m_entity_manager->GetEntityState(entity_id) != EntityState::ACTIVE ||
+           !(m_entity_manager->GetEntitySignature(entity_id) & m_system_signature))
         {
-            HandleEntity(i, delta_time);
+            continue;
         }
+        HandleEntity(entity_id, delta_time);
+    }
+}
+
+void System::UpdateRange(uint32_t begin, uint32_t end, float delta_time)
+{
+    uint32_t* entities = m_entity_manager->GetQueryEntities(m_query_id);
+    for(uint32_t i = begin; i < end; i++)
+    {
+        HandleEntity(entities[i], delta_time);
+    }
+}
+
+uint32_t System::GetNumEntities()
+{
+    return m_entity_manager->GetQuerySize(m_query_id);
+}
+
+uint32_t System::GetReadAccess()
+{
+    return m_read_access;
+}
+
+uint32_t System::GetWriteAccess()
+{
+    return m_write_access;
+}
+
+bool System::IsChunkable()
+{
+    return m_chunkable;
+}
+
+// Systems that never declare their access are treated as touching everything
+void System::DeclareAccess(uint32_t read_access, uint32_t write_access, bool chunkable)
+{
+    m_read_access = read_access | write_access;
+    m_write_access = write_access;
+    m_chunkable = chunkable;
+}
+
+// HandleMessage only sees the message types a system subscribes to
+void System::Subscribe(MessageType message_type)
+{
+    m_message_bus.Subscribe(this, message_type);
+}
+
+// Call after writing an entity's Transform so its cached model matrix gets
+// rebuilt. Only flags an existing ModelMatrix, so it is safe from job threads.
+void System::MarkTransformChanged(uint32_t entity_id)
+{
+    if(m_component_manager->HasComponent<ModelMatrix>(entity_id))
+    {
+        m_component_manager->GetComponent<ModelMatrix>(entity_id).dirty = true;
     }
 }
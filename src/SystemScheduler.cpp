@@ -0,0 +1,86 @@
+#include "SystemScheduler.hpp"
+
+SystemScheduler::SystemScheduler(JobSystem& job_system, uint32_t chunk_size) :
+    m_job_system(job_system),
+    m_chunk_size(chunk_size > 0 ? chunk_size : 1),
+    m_num_stages(0)
+{
+
+}
+
+SystemScheduler::~SystemScheduler()
+{
+
+}
+
+void SystemScheduler::AddSystem(System* system)
+{
+    uint32_t stage = 0;
+    for(uint32_t i = 0; i < m_systems.size(); i++)
+    {
+        if(Conflicts(m_systems[i], system) && m_system_stages[i] + 1 > stage)
+        {
+            stage = m_system_stages[i] + 1;
+        }
+    }
+
+    m_systems.push_back(system);
+    m_system_stages.push_back(stage);
+    m_system_jobs.resize(m_systems.size());
+    if(stage + 1 > m_num_stages)
+    {
+        m_num_stages = stage + 1;
+    }
+}
+
+void SystemScheduler::Update(float delta_time)
+{
+    for(uint32_t stage = 0; stage < m_num_stages; stage++)
+    {
+        JobCounter counter(0);
+        for(uint32_t i = 0; i < m_systems.size(); i++)
+        {
+            if(m_system_stages[i] != stage)
+            {
+                continue;
+            }
+
+            SystemJob& system_job = m_system_jobs[i];
+            system_job.system = m_systems[i];
+            system_job.delta_time = delta_time;
+
+            if(system_job.system->IsChunkable())
+            {
+                m_job_system.SubmitRange(RunSystemRange, &system_job, system_job.system->GetNumEntities(), m_chunk_size, counter);
+            }
+            else
+            {
+                m_job_system.Submit(RunSystem, &system_job, 0, 1, counter);
+            }
+        }
+        m_job_system.Wait(counter);
+    }
+}
+
+uint32_t SystemScheduler::GetNumStages()
+{
+    return m_num_stages;
+}
+
+void SystemScheduler::RunSystem(void* data, uint32_t /*begin*/, uint32_t /*end*/)
+{
+    SystemJob* system_job = (SystemJob*)data;
+    system_job->system->Update(system_job->delta_time);
+}
+
+void SystemScheduler::RunSystemRange(void* data, uint32_t begin, uint32_t end)
+{
+    SystemJob* system_job = (SystemJob*)data;
+    system_job->system->UpdateRange(begin, end, system_job->delta_time);
+}
+
+bool SystemScheduler::Conflicts(System* a, System* b)
+{
+    return (a->GetWriteAccess() & (b->GetReadAccess() | b->GetWriteAccess())) ||
+           (b->GetWriteAccess() & a->GetReadAccess());
+}
@@ -0,0 +1,77 @@
+#include <cstdio>
+
+#include "TextureArray.hpp"
+
+TextureArray::TextureArray(uint32_t layer_width, uint32_t layer_height) :
+    m_layer_width(layer_width),
+    m_layer_height(layer_height),
+    m_num_layers(0)
+{
+
+}
+
+TextureArray::~TextureArray()
+{
+
+}
+
+uint32_t TextureArray::AddLayer(const unsigned char* pixels, uint32_t width, uint32_t height)
+{
+    uint32_t layer_size = m_layer_width * m_layer_height * 4;
+    uint32_t layer_index = m_num_layers;
+    m_num_layers++;
+    m_pixels.resize(m_num_layers * layer_size, 0);
+
+    if(pixels == NULL || width == 0 || height == 0)
+    {
+        return layer_index;
+    }
+
+    TileImage(pixels, width, height, m_layer_width, m_layer_height, &m_pixels[layer_index * layer_size]);
+
+    return layer_index;
+}
+
+void TextureArray::TileImage(const unsigned char* pixels, uint32_t width, uint32_t height,
+                             uint32_t layer_width, uint32_t layer_height, unsigned char* layer)
+{
+    if(layer_width % width != 0 || layer_height % height != 0)
+    {
+        printf("Texture of %ux%u does not tile a %ux%u layer and will show seams\n",
+               width, height, layer_width, layer_height);
+    }
+
+    for(uint32_t y = 0; y < layer_height; y++)
+    {
+        const unsigned char* source_row = pixels + (y % height) * width * 4;
+        unsigned char* row = layer + y * layer_width * 4;
+        for(uint32_t x = 0; x < layer_width; x++)
+        {
+            const unsigned char* source_texel = source_row + (x % width) * 4;
+            row[x * 4 + 0] = source_texel[0];
+            row[x * 4 + 1] = source_texel[1];
+            row[x * 4 + 2] = source_texel[2];
+            row[x * 4 + 3] = source_texel[3];
+        }
+    }
+}
+
+uint32_t TextureArray::GetLayerWidth()
+{
+    return m_layer_width;
+}
+
+uint32_t TextureArray::GetLayerHeight()
+{
+    return m_layer_height;
+}
+
+uint32_t TextureArray::GetNumLayers()
+{
+    return m_num_layers;
+}
+
+const unsigned char* TextureArray::GetPixels()
+{
+    return m_pixels.empty() ? NULL : &m_pixels[0];
+}
@@ -0,0 +1,106 @@
+#include <cstring>
+
+#include "TextureContainer.hpp"
+
+// Full chain down to 1x1, which is log2 of the larger side plus one
+static uint32_t GetNumMips(uint32_t width, uint32_t height)
+{
+    uint32_t num_mips = 1;
+    while((width >> (num_mips - 1)) > 1 || (height >> (num_mips - 1)) > 1)
+    {
+        num_mips++;
+    }
+    return num_mips;
+}
+
+void WriteTextureContainer(const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t num_channels,
+                           std::vector<unsigned char>& container)
+{
+    uint32_t num_mips = GetNumMips(width, height);
+
+    TextureContainerHeader header;
+    header.magic = texture_container_magic;
+    header.version = texture_container_version;
+    header.width = width;
+    header.height = height;
+    header.num_channels = num_channels;
+    header.format = num_channels;
+    header.num_mips = num_mips;
+    header.reserved = 0;
+
+    std::vector<TextureContainerMip> mips(num_mips);
+    uint32_t offset = sizeof(TextureContainerHeader) + num_mips * sizeof(TextureContainerMip);
+    for(uint32_t i = 0; i < num_mips; i++)
+    {
+        mips[i].width = width >> i > 0 ? width >> i : 1;
+        mips[i].height = height >> i > 0 ? height >> i : 1;
+        mips[i].offset = offset;
+        mips[i].size = mips[i].width * mips[i].height * num_channels;
+        offset += mips[i].size;
+    }
+
+    container.resize(offset);
+    memcpy(&container[0], &header, sizeof(TextureContainerHeader));
+    memcpy(&container[sizeof(TextureContainerHeader)], &mips[0], num_mips * sizeof(TextureContainerMip));
+    memcpy(&container[mips[0].offset], pixels, mips[0].size);
+
+    // Each level averages up to 2x2 texels of the one above it
+    for(uint32_t i = 1; i < num_mips; i++)
+    {
+        const TextureContainerMip& source_mip = mips[i - 1];
+        const TextureContainerMip& mip = mips[i];
+        const unsigned char* source = &container[source_mip.offset];
+        unsigned char* destination = &container[mip.offset];
+        for(uint32_t y = 0; y < mip.height; y++)
+        {
+            uint32_t y0 = y * 2 < source_mip.height ? y * 2 : source_mip.height - 1;
+            uint32_t y1 = y * 2 + 1 < source_mip.height ? y * 2 + 1 : y0;
+            for(uint32_t x = 0; x < mip.width; x++)
+            {
+                uint32_t x0 = x * 2 < source_mip.width ? x * 2 : source_mip.width - 1;
+                uint32_t x1 = x * 2 + 1 < source_mip.width ? x * 2 + 1 : x0;
+                for(uint32_t c = 0; c < num_channels; c++)
+                {
+                    uint32_t sum = source[(y0 * source_mip.width + x0) * num_channels + c] +
+                                   source[(y0 * source_mip.width + x1) * num_channels + c] +
+                                   source[(y1 * source_mip.width + x0) * num_channels + c] +
+                                   source[(y1 * source_mip.width + x1) * num_channels + c];
+                    destination[(y * mip.width + x) * num_channels + c] = (sum + 2) / 4;
+                }
+            }
+        }
+    }
+}
+
+bool ReadTextureContainer(const unsigned char* data, size_t size,
+                          const TextureContainerHeader*& header, const TextureContainerMip*& mips)
+{
+    if(data == NULL || size < sizeof(TextureContainerHeader))
+    {
+        return false;
+    }
+
+    // Sizes are worked out in 64 bits so a crafted header can't wrap them
+    header = (const TextureContainerHeader*)data;
+    if(header->magic != texture_container_magic || header->version != texture_container_version ||
+       header->num_channels == 0 || header->num_channels > 4 || header->format != header->num_channels ||
+       header->width == 0 || header->height == 0 || header->num_mips == 0 ||
+       header->num_mips > GetNumMips(header->width, header->height) ||
+       (uint64_t)size < sizeof(TextureContainerHeader) + (uint64_t)header->num_mips * sizeof(TextureContainerMip))
+    {
+        return false;
+    }
+
+    mips = (const TextureContainerMip*)(data + sizeof(TextureContainerHeader));
+    for(uint32_t i = 0; i < header->num_mips; i++)
+    {
+        uint64_t mip_size = (uint64_t)mips[i].width * mips[i].height * header->num_channels;
+        if(mips[i].width == 0 || mips[i].height == 0 ||
+           mips[i].width > header->width || mips[i].height > header->height ||
+           mips[i].size != mip_size || (uint64_t)mips[i].offset + mips[i].size > (uint64_t)size)
+        {
+            return false;
+        }
+    }
+    return true;
+}
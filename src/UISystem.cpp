@@ -2,8 +2,6 @@
 #include <algorithm>
 #include <cstdio>
 
-#include "stb_image.h"
-
 #include "UISystem.hpp"
 
 static const char* ui_vertex_shader_text =
@@ -38,88 +36,42 @@ const vec2 character_extent = { 15, 22 };
 const uint32_t character_stride = 15;
 const vec2 texture_size = { 512, 512 };
 
-struct UIVertexData
-{
-    float x;
-    float y;
-    float z;
-    float r;
-    float g;
-    float b;
-    float u;
-    float v;
-};
-
-UISystem::UISystem(MessageBus& message_bus, GLFWwindow* window) : 
-    System(message_bus, UI_SYSTEM_IMAGE_SIGNATURE),
-    m_window(window)
+UISystem::UISystem(MessageBus& message_bus, GLFWwindow* window, ShaderCache& shader_cache, AssetLoader& asset_loader) : 
+    System(message_bus, UI_SYSTEM_IMAGE_SIGNATURE | UI_SYSTEM_TEXT_SIGNATURE),
+    m_window(window),
+    m_asset_loader(asset_loader),
+    m_ui_image_id(invalid_image_id),
+    m_shader_program(0),
+    m_vpos_location(-1),
+    m_vcolor_location(-1),
+    m_vtex_coord_location(-1),
+    m_vertex_buffer(0)
 {   
+    DeclareAccess(TRANSFORM_ACCESS | QUAD_ACCESS | TEXTURE_ACCESS | LABEL_ACCESS | ENTITY_STATE_ACCESS, 0, false);
+
     glGenTextures(1, &m_ui_texture);
     glBindTexture(GL_TEXTURE_2D, m_ui_texture);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    int32_t width, height, num_channels;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char *data = stbi_load("assets/UITexture.png", &width, &height, &num_channels, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
+    // Draw nothing until the loader has decoded the real texture
+    const unsigned char placeholder_texel[4] = { 0, 0, 0, 0 };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder_texel);
+    m_ui_image_id = asset_loader.LoadImage("assets/UITexture.png", 4);
 
-    GLuint ui_render_vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(ui_render_vertex_shader, 1, &ui_vertex_shader_text, NULL);
-    glCompileShader(ui_render_vertex_shader);
-
-    GLint isCompiled = 0;
-    glGetShaderiv(ui_render_vertex_shader, GL_COMPILE_STATUS, &isCompiled);
-    if(isCompiled == GL_FALSE)
+    m_shader_program = shader_cache.GetProgram(ui_vertex_shader_text, ui_fragment_shader_text);
+    if(m_shader_program == 0)
     {
-        GLint maxLength = 0;
-        glGetShaderiv(ui_render_vertex_shader, GL_INFO_LOG_LENGTH, &maxLength);
-
-        // The maxLength includes the NULL character
-        std::vector<GLchar> errorLog(maxLength);
-        glGetShaderInfoLog(ui_render_vertex_shader, maxLength, &maxLength, &errorLog[0]);
-        printf("%s\n", errorLog.data());
-
-        // Provide the infolog in whatever manor you deem best.
-        // Exit with failure.
-        glDeleteShader(ui_render_vertex_shader); // Don't leak the shader.
         return;
     }
- 
-    GLuint ui_render_fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(ui_render_fragment_shader, 1, &ui_fragment_shader_text, NULL);
-    glCompileShader(ui_render_fragment_shader);
-
-    isCompiled = 0;
-    glGetShaderiv(ui_render_fragment_shader, GL_COMPILE_STATUS, &isCompiled);
-    if(isCompiled == GL_FALSE)
-    {
-        GLint maxLength = 0;
-        glGetShaderiv(ui_render_fragment_shader, GL_INFO_LOG_LENGTH, &maxLength);
-
-        // The maxLength includes the NULL character
-        std::vector<GLchar> errorLog(maxLength);
-        glGetShaderInfoLog(ui_render_fragment_shader, maxLength, &maxLength, &errorLog[0]);
-        printf("%s\n", errorLog.data());
-
-        // Provide the infolog in whatever manor you deem best.
-        // Exit with failure.
-        glDeleteShader(ui_render_fragment_shader); // Don't leak the shader.
-        return;
-    }
- 
-    m_shader_program = glCreateProgram();
-    glAttachShader(m_shader_program, ui_render_vertex_shader);
-    glAttachShader(m_shader_program, ui_render_fragment_shader);
-    glLinkProgram(m_shader_program);
-    glDeleteShader(ui_render_vertex_shader);
-    glDeleteShader(ui_render_fragment_shader);
+    m_vpos_location = shader_cache.GetAttribLocation(m_shader_program, "vPos");
+    m_vcolor_location = shader_cache.GetAttribLocation(m_shader_program, "vColor");
+    m_vtex_coord_location = shader_cache.GetAttribLocation(m_shader_program, "vTexCoord");
 
+    glGenBuffers(1, &m_vertex_buffer);
 }
 
 UISystem::~UISystem()
@@ -193,8 +145,7 @@ void UISystem::HandleEntity(uint32_t entity_id, float delta_time)
                             label.color[0], label.color[1], label.color[2],
                             (texture_start_index[0] + character_extent[0]) / texture_size[0],  texture_start_index[1] / texture_size[1] };
 
-            glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_DYNAMIC_DRAW);
-            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            AddQuad(vertices);
         }
     }
     else if(signature & UI_SYSTEM_IMAGE_SIGNATURE)
@@ -227,8 +178,7 @@ void UISystem::HandleEntity(uint32_t entity_id, float delta_time)
                         0, 0, 0,
                         (texture.position[0] + texture.size[0]) / 512, texture.position[1] / 512 };
 
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_DYNAMIC_DRAW);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        AddQuad(vertices);
     }
 }
 
@@ -237,31 +187,64 @@ void UISystem::Update(float delta_time)
     // glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, m_ui_texture);
 
+    if(m_ui_image_id != invalid_image_id && m_asset_loader.IsImageReady(m_ui_image_id))
+    {
+        uint32_t num_mips = m_asset_loader.GetImageNumMips(m_ui_image_id);
+        for(uint32_t level = 0; level < num_mips; level++)
+        {
+            ImageMip mip = m_asset_loader.GetImageMip(m_ui_image_id, level);
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip.pixels);
+        }
+        if(num_mips == 1)
+        {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        else
+        {
+            // Stay complete even if a container stops short of 1x1
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_mips - 1);
+        }
+        m_asset_loader.FreeImage(m_ui_image_id);
+        m_ui_image_id = invalid_image_id;
+    }
+
+    if(m_shader_program == 0)
+    {
+        return;
+    }
+
     glUseProgram(m_shader_program);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
 
-    uint32_t vpos_location = glGetAttribLocation(m_shader_program, "vPos");
-    uint32_t vcolor_location = glGetAttribLocation(m_shader_program, "vColor");
-    uint32_t vtex_coord_location = glGetAttribLocation(m_shader_program, "vTexCoord");
  
-    glEnableVertexAttribArray(vpos_location);
-    glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE,
+    glEnableVertexAttribArray(m_vpos_location);
+    glVertexAttribPointer(m_vpos_location, 3, GL_FLOAT, GL_FALSE,
                           sizeof(UIVertexData), (void*) 0);
-    glEnableVertexAttribArray(vcolor_location);
-    glVertexAttribPointer(vcolor_location, 3, GL_FLOAT, GL_FALSE,
+    glEnableVertexAttribArray(m_vcolor_location);
+    glVertexAttribPointer(m_vcolor_location, 3, GL_FLOAT, GL_FALSE,
                           sizeof(UIVertexData), (void*) (sizeof(float) * 3));
-    glEnableVertexAttribArray(vtex_coord_location);
-    glVertexAttribPointer(vtex_coord_location, 2, GL_FLOAT, GL_FALSE,
+    glEnableVertexAttribArray(m_vtex_coord_location);
+    glVertexAttribPointer(m_vtex_coord_location, 2, GL_FLOAT, GL_FALSE,
                           sizeof(UIVertexData), (void*) (sizeof(float) * 6));
 
-    uint32_t num_entities = m_entity_manager->GetNumEntities();
-    
-    for(uint32_t i = 0; i < num_entities; i++)
+    // Gather every glyph and image first, then draw them in one call
+    m_vertices.clear();
+    System::Update(delta_time);
+
+    if(!m_vertices.empty())
     {
-        if(m_entity_manager->GetEntityState(i) == EntityState::ACTIVE &&
-            (m_entity_manager->GetEntitySignature(i) & UI_SYSTEM_IMAGE_SIGNATURE ||
-             m_entity_manager->GetEntitySignature(i) & UI_SYSTEM_TEXT_SIGNATURE ))
-        {
-            HandleEntity(i, delta_time);
-        }
+        glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(UIVertexData), &m_vertices[0], GL_DYNAMIC_DRAW);
+        glDrawArrays(GL_TRIANGLES, 0, m_vertices.size());
     }
+}
+
+// Vertices come in triangle strip order
+void UISystem::AddQuad(const UIVertexData* vertices)
+{
+    m_vertices.push_back(vertices[0]);
+    m_vertices.push_back(vertices[1]);
+    m_vertices.push_back(vertices[2]);
+    m_vertices.push_back(vertices[2]);
+    m_vertices.push_back(vertices[1]);
+    m_vertices.push_back(vertices[3]);
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <chrono>
 #include <thread>
 #include <vector>
@@ -19,7 +20,13 @@
 #include "PhysicsSystem.hpp"
 #include "RenderSystem.hpp"
 #include "UISystem.hpp"
+#include "ShaderCache.hpp"
+#include "AssetLoader.hpp"
 #include "AISystem.hpp"
+#include "CollisionLayers.hpp"
+#include "SimulationClock.hpp"
+#include "JobSystem.hpp"
+#include "SystemScheduler.hpp"
  
 static void error_callback(int error, const char* description)
 {
@@ -74,7 +81,6 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
 int main(int argv, char* args[])
 { 
     GLFWwindow* window;
-    GLuint vertex_buffer;
     GLuint quad_render_vertex_shader, quad_render_fragment_shader, quad_render_program;
     GLuint ui_render_vertex_shader, ui_render_fragment_shader, ui_render_program;
  
@@ -111,9 +117,6 @@ int main(int argv, char* args[])
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
-    glGenBuffers(1, &vertex_buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-
     uint32_t num_inputs = 13;
     uint32_t input_list[] = { GLFW_KEY_LEFT,
                                 GLFW_KEY_RIGHT,
@@ -135,7 +138,8 @@ int main(int argv, char* args[])
         input_map->AddInput(input_list[i]);
     }
     
-    const uint32_t num_entities = 177;
+    // Starting capacity, both managers grow as entities are created
+    const uint32_t num_entities = 170;
     EntityManager entity_manager(num_entities);
     ComponentManager component_manager(num_entities);
     GenerateEntities(entity_manager, component_manager);
@@ -143,7 +147,8 @@ int main(int argv, char* args[])
 
     const uint32_t num_messages = 1024;
     const uint32_t num_systems = 5;
-    MessageBus message_bus(num_messages, num_systems);
+    // Collision bursts shouldn't lose messages, so let the queue grow instead
+    MessageBus message_bus(num_messages, num_systems, MESSAGE_OVERFLOW_GROW);
 
     PlayerInputSystem player_input_system(message_bus, *input_map);
     player_input_system.SetEntityManager(&entity_manager);
@@ -151,27 +156,59 @@ int main(int argv, char* args[])
     PhysicsSystem physics_system(message_bus);
     physics_system.SetEntityManager(&entity_manager);
     physics_system.SetComponentManager(&component_manager);
-    RenderSystem render_system(message_bus, *input_map);
+    physics_system.BuildStaticColliders();
+    // Images decode on the job system while the rest of startup continues
+    JobSystem job_system(std::thread::hardware_concurrency());
+    AssetLoader asset_loader(job_system);
+    ShaderCache shader_cache("shader_cache");
+    RenderSystem render_system(message_bus, *input_map, shader_cache, asset_loader);
     render_system.SetEntityManager(&entity_manager);
     render_system.SetComponentManager(&component_manager);
-    UISystem ui_system(message_bus, window);
+    render_system.BakeStaticGeometry();
+    UISystem ui_system(message_bus, window, shader_cache, asset_loader);
     ui_system.SetEntityManager(&entity_manager);
     ui_system.SetComponentManager(&component_manager);
     AISystem ai_system(message_bus);
     ai_system.SetEntityManager(&entity_manager);
     ai_system.SetComponentManager(&component_manager);
 
+    const ShaderCacheStats& shader_stats = shader_cache.GetStats();
+    printf("Shaders: %u compiled, %u loaded from cache, %u reused in %.2f ms\n", shader_stats.programs_compiled,
+           shader_stats.programs_loaded, shader_stats.programs_reused, shader_stats.milliseconds);
+
+    // Render and UI issue GL calls so they stay on this thread. AI and
+    // player input both write transforms, and player input creates and
+    // destroys bullets, so they always land in separate stages. The gain
+    // here is AI's entities being split across workers.
+    const uint32_t entities_per_job = 64;
+    SystemScheduler simulation_scheduler(job_system, entities_per_job);
+    simulation_scheduler.AddSystem(&ai_system);
+    simulation_scheduler.AddSystem(&player_input_system);
+
     
+    const uint32_t physics_steps_per_second = 60;
+    const uint32_t max_physics_steps_per_frame = 5;
+    SimulationClock simulation_clock(physics_steps_per_second, max_physics_steps_per_frame);
+
     std::chrono::time_point<std::chrono::steady_clock> prev_time = std::chrono::steady_clock::now();
     uint32_t num_frames = 0;
-    uint32_t MS_PER_FRAME = 16;
+    uint64_t stats_nanoseconds = 0;
+    bool print_render_stats = false;
+    for(int i = 1; i < argv; i++)
+    {
+        if(strcmp(args[i], "--stats") == 0)
+        {
+            print_render_stats = true;
+        }
+    }
 
     bool is_running = true;
 
     while (!glfwWindowShouldClose(window))
     {
         std::chrono::time_point<std::chrono::steady_clock> current_time = std::chrono::steady_clock::now();
-        float delta_time = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - prev_time).count() * 1e-3;
+        uint64_t elapsed_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(current_time - prev_time).count();
+        float delta_time = elapsed_nanoseconds * 1e-9;
         prev_time = current_time;
 
         glfwPollEvents();
@@ -187,19 +224,37 @@ int main(int argv, char* args[])
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); 
 
         message_bus.Update();
-        ai_system.Update(delta_time);
-        player_input_system.Update(delta_time);
-        physics_system.Update(delta_time);
+        simulation_scheduler.Update(delta_time);
+
+        simulation_clock.Advance(elapsed_nanoseconds);
+        while(simulation_clock.Step())
+        {
+            physics_system.Update(simulation_clock.GetStepTime());
+        }
+        render_system.SetInterpolationAlpha(simulation_clock.GetAlpha());
+
         glEnable(GL_DEPTH_TEST);
         render_system.Update(delta_time);
         glDisable(GL_DEPTH_TEST);
         ui_system.Update(delta_time);
 
         glfwSwapBuffers(window);
-        
-        // Calculate time to sleep and sleep if necessary
-        std::chrono::time_point<std::chrono::steady_clock> next_frame_time = current_time + std::chrono::milliseconds(MS_PER_FRAME);
-        std::this_thread::sleep_until(next_frame_time);
+
+        // With --stats, report the render counters about once a second
+        if(print_render_stats)
+        {
+            num_frames++;
+            stats_nanoseconds += elapsed_nanoseconds;
+            if(stats_nanoseconds >= 1000000000ull)
+            {
+                const RenderStats& render_stats = render_system.GetRenderStats();
+                printf("%u fps, %u matrix builds, %u gl calls, %u draw calls, %u visible and %u culled quads per frame\n", num_frames,
+                       render_stats.matrix_builds, render_stats.gl_calls, render_stats.draw_calls,
+                       render_stats.visible_quads, render_stats.culled_quads);
+                num_frames = 0;
+                stats_nanoseconds = 0;
+            }
+        }
     }
  
     glfwDestroyWindow(window);
@@ -232,11 +287,28 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     bounding_box.extent[1] = 1.5;
     bounding_box.extent[2] = 0.15;
 
+    CollisionLayer collision_layer;
+    collision_layer.category = PLAYER_COLLISION_LAYER;
+    collision_layer.collides_with = ALL_COLLISION_LAYERS;
+    collision_layer.reports_to = 0;
+
     PlayerInput player_input;
     player_input.score = 0;
     player_input.timer = 60;
     player_input.state = PlayerState::INIT;
 
+    RigidBody rigid_body;
+    rigid_body.velocity[0] = 0;
+    rigid_body.velocity[1] = 0;
+    rigid_body.velocity[2] = 0;
+    rigid_body.acceleration[0] = 0;
+    rigid_body.acceleration[1] = 0;
+    rigid_body.acceleration[2] = 0;
+    rigid_body.previous_position[0] = transform.position[0];
+    rigid_body.previous_position[1] = transform.position[1];
+    rigid_body.previous_position[2] = transform.position[2];
+
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
     entity_manager.SetEntitySignature(entity_id, PLAYER_INPUT_SYSTEM_SIGNATURE |
                                                     PHYSICS_SYSTEM_SIGNATURE |
@@ -245,9 +317,9 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
 
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<BoundingBox>(entity_id, bounding_box);
+    component_manager.AddComponent<CollisionLayer>(entity_id, collision_layer);
     component_manager.AddComponent<PlayerInput>(entity_id, player_input);
-
-    entity_id++;
+    component_manager.AddComponent<RigidBody>(entity_id, rigid_body);
 
     uint32_t num_windows = 5;
     float window_width = 0.6;
@@ -270,13 +342,18 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     bounding_box.extent[1] = wall_height / 3;
     bounding_box.extent[2] = .1;
 
+    collision_layer.category = WALL_COLLISION_LAYER;
+    collision_layer.collides_with = ALL_COLLISION_LAYERS;
+    collision_layer.reports_to = 0;
+
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
-    entity_manager.SetEntitySignature(entity_id, COLLISION_SYSTEM_SIGNATURE);
+    entity_manager.SetEntitySignature(entity_id, COLLISION_SYSTEM_SIGNATURE |
+                                                    STATIC_SIGNATURE);
 
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<BoundingBox>(entity_id, bounding_box);
-
-    entity_id++;
+    component_manager.AddComponent<CollisionLayer>(entity_id, collision_layer);
 
     vec3 my_floor_offset = { 0, 0, 0 };
     GenerateFloor(entity_manager, component_manager, entity_id, my_floor_offset, num_windows, window_width, window_width, wall_total_width, wall_height, true);
@@ -314,15 +391,14 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     texture.size[1] = 85;
     texture.use_light = false;
 
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
-    entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE);
+    entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE | STATIC_SIGNATURE);
 
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Quad>(entity_id, quad);
     component_manager.AddComponent<Texture>(entity_id, texture);
 
-    entity_id++;
-
     // Road Entity
     transform.position[0] = 0;
     transform.position[1] = other_floor_offset[1] - 0.1;
@@ -344,15 +420,14 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     texture.size[1] = 85;
     texture.use_light = false;
 
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
-    entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE);
+    entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE | STATIC_SIGNATURE);
 
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Quad>(entity_id, quad);
     component_manager.AddComponent<Texture>(entity_id, texture);
 
-    entity_id++;
-
     // Sidewalk Entity
     transform.position[0] = 0;
     transform.position[1] = other_floor_offset[1] - 0.1;
@@ -374,15 +449,14 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     texture.size[1] = 85;
     texture.use_light = false;
 
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
-    entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE);
+    entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE | STATIC_SIGNATURE);
 
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Quad>(entity_id, quad);
     component_manager.AddComponent<Texture>(entity_id, texture);
 
-    entity_id++;
-
     // Timer Label
     // transform.position[0] = (640 / 2) - (15 * 2) / 2;
     // transform.position[1] = 480 - 25;
@@ -401,6 +475,7 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     // label.text = new char[10];
     // snprintf(label.text, 10, "00");
 
+    // entity_id = GetEntityIndex(entity_manager.Create());
     // entity_manager.SetEntityState(entity_id, EntityState::INACTIVE);
     // entity_manager.SetEntitySignature(entity_id, UI_SYSTEM_TEXT_SIGNATURE);
     // entity_manager.SetEntityTag(entity_id, "timer_entity");
@@ -408,8 +483,6 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     // component_manager.AddComponent<Transform>(entity_id, transform);
     // component_manager.AddComponent<Label>(entity_id, label);
 
-    // entity_id++;
-
     // Timer Label
     transform.position[0] = (640 / 2) - (15 * 2) / 2;
     transform.position[1] = 480 - 25;
@@ -428,6 +501,7 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     label.text = new char[10];
     snprintf(label.text, 10, "00");
 
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::INACTIVE);
     entity_manager.SetEntitySignature(entity_id, UI_SYSTEM_TEXT_SIGNATURE);
     entity_manager.SetEntityTag(entity_id, "timer_entity");
@@ -435,8 +509,6 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Label>(entity_id, label);
 
-    entity_id++;
-
     // Title Label
     transform.position[0] = (640 / 2) - ((15 * 11 * 2) / 2);
     transform.position[1] = (480 / 2) - ((22 * 2) / 2) + 22 * 3;
@@ -454,6 +526,7 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     label.text = new char[12];
     snprintf(label.text, 12, "XRAY SNIPER");
 
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
     entity_manager.SetEntitySignature(entity_id, UI_SYSTEM_TEXT_SIGNATURE);
     entity_manager.SetEntityTag(entity_id, "title_entity");
@@ -461,8 +534,6 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Label>(entity_id, label);
 
-    entity_id++;
-
     // Win Label
     transform.position[0] = (640 / 2) - ((15 * 3 * 2) / 2);
     transform.position[1] = (480 / 2) - ((22 * 2) / 2) + 22 * 3;
@@ -480,6 +551,7 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     label.text = new char[12];
     snprintf(label.text, 12, "WIN");
 
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::INACTIVE);
     entity_manager.SetEntitySignature(entity_id, UI_SYSTEM_TEXT_SIGNATURE);
     entity_manager.SetEntityTag(entity_id, "win_entity");
@@ -487,8 +559,6 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Label>(entity_id, label);
 
-    entity_id++;
-
     // Lose Label
     transform.position[0] = (640 / 2) - ((15 * 4 * 2) / 2);
     transform.position[1] = (480 / 2) - ((22 * 2) / 2) + 22 * 3;
@@ -506,6 +576,7 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     label.text = new char[12];
     snprintf(label.text, 12, "LOSE");
 
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::INACTIVE);
     entity_manager.SetEntitySignature(entity_id, UI_SYSTEM_TEXT_SIGNATURE);
     entity_manager.SetEntityTag(entity_id, "lose_entity");
@@ -513,8 +584,6 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Label>(entity_id, label);
 
-    entity_id++;
-
     // Crosshair 
     transform.position[0] = 640 / 2;
     transform.position[1] = 480 / 2;
@@ -534,6 +603,7 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     quad.extent[0] = 640 / 2;
     quad.extent[1] = 480 / 2;
 
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::INACTIVE);
     entity_manager.SetEntitySignature(entity_id, UI_SYSTEM_IMAGE_SIGNATURE);
     entity_manager.SetEntityTag(entity_id, "crosshair");
@@ -542,57 +612,43 @@ void GenerateEntities(EntityManager& entity_manager, ComponentManager& component
     component_manager.AddComponent<Texture>(entity_id, texture);
     component_manager.AddComponent<Quad>(entity_id, quad);
 
-    entity_id++;
-
-    // Bullets
-    for(uint32_t i = 0; i < 32; i++)
+    // Lights, a row along the player's floor and four rows down the
+    // building across the street
+    vec3 light_rows[5] = { { 0, 2.5, 0 },
+                           { 0, 5, -10 },
+                           { 0, 2.5, -10 },
+                           { 0, 0, -10 },
+                           { 0, -2.5, -10 } };
+    for(uint32_t i = 0; i < 5; i++)
     {
-        transform.position[0] = 0;
-        transform.position[1] = 0;
-        transform.position[2] = 0;
-        transform.rotation[0] = 0;
-        transform.rotation[1] = 0;
-        transform.rotation[2] = 0;
-        transform.scale[0] = 0;
-        transform.scale[1] = 0;
-        transform.scale[2] = 0;
-        
-        texture.texture_index = 2;
-        texture.position[0] = 0;
-        texture.position[1] = 257;
-        texture.size[0] = 63;
-        texture.size[1] = 63;
-
-        quad.extent[0] = 0.1;
-        quad.extent[1] = 0.1;
-
-        bounding_box.extent[0] = 0.1;
-        bounding_box.extent[1] = 0.1;
-        bounding_box.extent[2] = 0.1;
-
-        RigidBody rigid_body;
-        rigid_body.velocity[0] = 0;
-        rigid_body.velocity[1] = 0;
-        rigid_body.velocity[2] = 0;
-        rigid_body.acceleration[0] = 0;
-        rigid_body.acceleration[1] = 0;
-        rigid_body.acceleration[2] = 0;
-
-        entity_manager.SetEntityState(entity_id, EntityState::INACTIVE);
-        entity_manager.SetEntitySignature(entity_id, PHYSICS_SYSTEM_SIGNATURE |
-                                                        COLLISION_SYSTEM_SIGNATURE);
-        char bullet_tag[10];
-        sprintf(bullet_tag, "bullet_%d", i);
-        entity_manager.SetEntityTag(entity_id, bullet_tag);
+        for(uint32_t j = 0; j < 5; j++)
+        {
+            transform.position[0] = -10.0 + 5.0 * j;
+            transform.position[1] = light_rows[i][1];
+            transform.position[2] = light_rows[i][2];
+            transform.rotation[0] = 0;
+            transform.rotation[1] = 0;
+            transform.rotation[2] = 0;
+            transform.scale[0] = 0;
+            transform.scale[1] = 0;
+            transform.scale[2] = 0;
 
-        component_manager.AddComponent<Transform>(entity_id, transform);
-        component_manager.AddComponent<Texture>(entity_id, texture);
-        component_manager.AddComponent<Quad>(entity_id, quad);
+            Light light;
+            light.color[0] = 0.5;
+            light.color[1] = 0.5;
+            light.color[2] = 0.5;
+            light.radius = 3;
 
-        entity_id++;
+            entity_id = GetEntityIndex(entity_manager.Create());
+            entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
+            entity_manager.SetEntitySignature(entity_id, LIGHT_SIGNATURE | STATIC_SIGNATURE);
+
+            component_manager.AddComponent<Transform>(entity_id, transform);
+            component_manager.AddComponent<Light>(entity_id, light);
+        }
     }
 
-    printf("Num Entities: %d\n", entity_id);
+    printf("Num Entities: %d\n", entity_manager.GetNumAliveEntities());
 }
 
 
@@ -681,8 +737,9 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
             texture.use_light = false;
         }
 
+        entity_id = GetEntityIndex(entity_manager.Create());
         entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
-        uint32_t signature = RENDER_SYSTEM_SIGNATURE;
+        uint32_t signature = RENDER_SYSTEM_SIGNATURE | STATIC_SIGNATURE;
         if(!my_building)
         {
             signature |= XRAY_SYSTEM_SIGNATURE;
@@ -692,8 +749,6 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
         component_manager.AddComponent<Transform>(entity_id, transform);
         component_manager.AddComponent<Quad>(entity_id, quad);
         component_manager.AddComponent<Texture>(entity_id, texture);
-
-        entity_id++;
     }
 
     // Front Window Entities
@@ -748,8 +803,9 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
             texture.use_light = false;
         }
 
+        entity_id = GetEntityIndex(entity_manager.Create());
         entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
-        uint32_t signature = RENDER_SYSTEM_SIGNATURE;
+        uint32_t signature = RENDER_SYSTEM_SIGNATURE | STATIC_SIGNATURE;
         if(!my_building)
         {
             signature |= XRAY_SYSTEM_SIGNATURE;
@@ -760,8 +816,6 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
         component_manager.AddComponent<Quad>(entity_id, quad);
         component_manager.AddComponent<Texture>(entity_id, texture);
 
-        entity_id++;
-
         // Top Wall
         transform.position[0] = window_pos_x + offset[0];
         transform.position[1] = wall_height - (wall_height / 3 / 2) + offset[1];
@@ -808,8 +862,9 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
             texture.use_light = false;
         }
 
+        entity_id = GetEntityIndex(entity_manager.Create());
         entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
-        signature = RENDER_SYSTEM_SIGNATURE;
+        signature = RENDER_SYSTEM_SIGNATURE | STATIC_SIGNATURE;
         if(!my_building)
         {
             signature |= XRAY_SYSTEM_SIGNATURE;
@@ -820,8 +875,6 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
         component_manager.AddComponent<Quad>(entity_id, quad);
         component_manager.AddComponent<Texture>(entity_id, texture);
 
-        entity_id++;
-
         // Window
         transform.position[0] = window_pos_x + offset[0];
         transform.position[1] = wall_height / 3 + wall_height / 3 / 2 + offset[1];
@@ -860,8 +913,9 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
         texture.size[0] = 128;
         texture.size[1] = 192;
 
+        entity_id = GetEntityIndex(entity_manager.Create());
         entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
-        signature = RENDER_SYSTEM_SIGNATURE;
+        signature = RENDER_SYSTEM_SIGNATURE | STATIC_SIGNATURE;
         if(!my_building)
         {
             signature |= XRAY_SYSTEM_SIGNATURE;
@@ -872,8 +926,6 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
         component_manager.AddComponent<Quad>(entity_id, quad);
         component_manager.AddComponent<Texture>(entity_id, texture);
 
-        entity_id++;
-
         window_pos_x += window_interval;
     }
     
@@ -926,17 +978,23 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
     bounding_box.extent[1] = wall_height;
     bounding_box.extent[2] = 1;
 
+    CollisionLayer collision_layer;
+    collision_layer.category = WALL_COLLISION_LAYER;
+    collision_layer.collides_with = ALL_COLLISION_LAYERS;
+    collision_layer.reports_to = 0;
+
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
     entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE |
-                                                    COLLISION_SYSTEM_SIGNATURE);
+                                                    COLLISION_SYSTEM_SIGNATURE |
+                                                    STATIC_SIGNATURE);
     entity_manager.SetEntityTag(entity_id, "back_wall");
 
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Quad>(entity_id, quad);
     component_manager.AddComponent<Texture>(entity_id, texture);
     component_manager.AddComponent<BoundingBox>(entity_id, bounding_box);
-
-    entity_id++;
+    component_manager.AddComponent<CollisionLayer>(entity_id, collision_layer);
     
     // Side Wall Entity
     transform.position[0] = (wall_total_width / 2) + offset[0];
@@ -966,17 +1024,22 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
     bounding_box.extent[1] = wall_height;
     bounding_box.extent[2] = 2;
 
+    collision_layer.category = SIDE_WALL_COLLISION_LAYER;
+    collision_layer.collides_with = ALL_COLLISION_LAYERS;
+    collision_layer.reports_to = 0;
+
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
     entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE |
-                                                    COLLISION_SYSTEM_SIGNATURE);
+                                                    COLLISION_SYSTEM_SIGNATURE |
+                                                    STATIC_SIGNATURE);
     entity_manager.SetEntityTag(entity_id, "side_wall");
 
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Quad>(entity_id, quad);
     component_manager.AddComponent<Texture>(entity_id, texture);
     component_manager.AddComponent<BoundingBox>(entity_id, bounding_box);
-
-    entity_id++;
+    component_manager.AddComponent<CollisionLayer>(entity_id, collision_layer);
     
     // Side Wall Entity
     transform.position[0] = -(wall_total_width / 2) + offset[0];
@@ -1006,17 +1069,22 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
     bounding_box.extent[1] = wall_height;
     bounding_box.extent[2] = 2;
 
+    collision_layer.category = SIDE_WALL_COLLISION_LAYER;
+    collision_layer.collides_with = ALL_COLLISION_LAYERS;
+    collision_layer.reports_to = 0;
+
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
     entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE |
-                                                    COLLISION_SYSTEM_SIGNATURE);
+                                                    COLLISION_SYSTEM_SIGNATURE |
+                                                    STATIC_SIGNATURE);
     entity_manager.SetEntityTag(entity_id, "side_wall");
 
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Quad>(entity_id, quad);
     component_manager.AddComponent<Texture>(entity_id, texture);
     component_manager.AddComponent<BoundingBox>(entity_id, bounding_box);
-
-    entity_id++;
+    component_manager.AddComponent<CollisionLayer>(entity_id, collision_layer);
     
     // Floor Entity
     transform.position[0] = 0 + offset[0];
@@ -1042,14 +1110,13 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
     texture.size[1] = 128 * 5;
     texture.use_light = true;
 
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
-    entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE);
+    entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE | STATIC_SIGNATURE);
 
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Quad>(entity_id, quad);
     component_manager.AddComponent<Texture>(entity_id, texture);
-
-    entity_id++;
     
     // Ceiling Entity
     transform.position[0] = 0 + offset[0];
@@ -1075,15 +1142,14 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
     texture.size[1] = 128 * 5;
     texture.use_light = true;
 
+    entity_id = GetEntityIndex(entity_manager.Create());
     entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
-    entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE);
+    entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE | STATIC_SIGNATURE);
 
     component_manager.AddComponent<Transform>(entity_id, transform);
     component_manager.AddComponent<Quad>(entity_id, quad);
     component_manager.AddComponent<Texture>(entity_id, texture);
 
-    entity_id++;
-
     vec3 enemy_extent = { 0.75, 1.5, .75 };
 
     if(!my_building)
@@ -1117,6 +1183,10 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
             bounding_box.extent[1] = enemy_extent[1];
             bounding_box.extent[2] = enemy_extent[2];
 
+            collision_layer.category = ENEMY_COLLISION_LAYER;
+            collision_layer.collides_with = ALL_COLLISION_LAYERS;
+            collision_layer.reports_to = SIDE_WALL_COLLISION_LAYER;
+
             RigidBody rigid_body;
             rigid_body.velocity[0] = speed;
             rigid_body.velocity[1] = 0;
@@ -1124,6 +1194,9 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
             rigid_body.acceleration[0] = 0;
             rigid_body.acceleration[1] = 0;
             rigid_body.acceleration[2] = 0;
+            rigid_body.previous_position[0] = transform.position[0];
+            rigid_body.previous_position[1] = transform.position[1];
+            rigid_body.previous_position[2] = transform.position[2];
 
             Animation animation;
             animation.counter = 0;
@@ -1143,6 +1216,7 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
             ai_data.rotation[1] = transform.rotation[1];
             ai_data.rotation[2] = transform.rotation[2];
 
+            entity_id = GetEntityIndex(entity_manager.Create());
             entity_manager.SetEntityState(entity_id, EntityState::ACTIVE);
             entity_manager.SetEntitySignature(entity_id, RENDER_SYSTEM_SIGNATURE | 
                                                             PHYSICS_SYSTEM_SIGNATURE |
@@ -1154,11 +1228,10 @@ void GenerateFloor(EntityManager& entity_manager, ComponentManager& component_ma
             component_manager.AddComponent<Quad>(entity_id, quad);
             component_manager.AddComponent<Texture>(entity_id, texture);
             component_manager.AddComponent<BoundingBox>(entity_id, bounding_box);
+            component_manager.AddComponent<CollisionLayer>(entity_id, collision_layer);
             component_manager.AddComponent<RigidBody>(entity_id, rigid_body);
             component_manager.AddComponent<Animation>(entity_id, animation);
             component_manager.AddComponent<AIData>(entity_id, ai_data);
-
-            entity_id++;
         }
     }
 }
\ No newline at end of file
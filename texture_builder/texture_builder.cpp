@@ -1,37 +1,79 @@
+// Turns images into data the game can load without decoding them.
+//
+//   texture_builder <image>                C header with the raw bytes
+//   texture_builder -c <image> [out.tex]   precooked texture container
+//   texture_builder -b <directory>         container for every png and jpg
+//                                          in the directory, in parallel
+//
+// Build with GCC on Linux or MinGW on Windows, both of which ship dirent.h
+//   g++ -std=c++11 -O2 -I../inc/Utils texture_builder.cpp ../src/TextureContainer.cpp -o texture_builder -pthread
+
 #include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-int main(int argc, char *argv[])
+#include "TextureContainer.hpp"
+
+// The game samples every texture as RGBA
+const uint32_t container_num_channels = 4;
+
+// strupr and strlwr only exist in the Windows C runtimes
+char* ToUpper(char* text)
+{
+    for(char* c = text; *c != '\0'; c++)
+    {
+        *c = toupper((unsigned char)*c);
+    }
+    return text;
+}
+
+char* ToLower(char* text)
+{
+    for(char* c = text; *c != '\0'; c++)
+    {
+        *c = tolower((unsigned char)*c);
+    }
+    return text;
+}
+
+int WriteHeader(char* image_path)
 {
     const uint32_t num_values_per_row = 10;
     int width, height, nrChannels;
     stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(argv[1], &width, &height, &nrChannels, 0);
+    unsigned char* data = stbi_load(image_path, &width, &height, &nrChannels, 0);
     uint32_t num_values = width * height * nrChannels;
 
-    uint32_t str_len = strlen(argv[1]);
+    uint32_t str_len = strlen(image_path);
     for(uint32_t i = str_len - 1; i > 0; i--)
     {
-        if(argv[1][i] == '.')
+        if(image_path[i] == '.')
         {
-            argv[1][i] = '\0';
+            image_path[i] = '\0';
             break;
         }
     }
 
-    char* texture_name;
+    char* texture_name = image_path;
     
     for(uint32_t i = str_len - 1; i > 0; i--)
     {
-        if(argv[1][i] == '/')
+        if(image_path[i] == '/')
         {
-            texture_name = &argv[1][i+1];
+            texture_name = &image_path[i+1];
             break;
         }
     }
-    texture_name = strupr(texture_name);
+    texture_name = ToUpper(texture_name);
 
     printf("#ifndef %s_H\n", texture_name);
     printf("#define %s_H\n", texture_name);
@@ -39,7 +81,7 @@ int main(int argc, char *argv[])
     printf("#include <stdint.h>\n");
     printf("\n");
     
-    texture_name = strlwr(texture_name);
+    texture_name = ToLower(texture_name);
     printf("uint32_t %s_width = %d;\n", texture_name, width);
     printf("uint32_t %s_height = %d;\n", texture_name, height);
     printf("uint32_t %s_num_channels = %d;\n", texture_name, nrChannels);
@@ -62,9 +104,158 @@ int main(int argc, char *argv[])
     printf("};\n");
     printf("\n");
 
-    texture_name = strupr(texture_name);
+    texture_name = ToUpper(texture_name);
     printf("#endif // %s\n", texture_name);
 
     stbi_image_free(data);
     return 0;
-}
\ No newline at end of file
+}
+
+// Replaces the extension, or appends one if there is none
+std::string GetContainerPath(const std::string& image_path)
+{
+    size_t extension = image_path.find_last_of('.');
+    size_t separator = image_path.find_last_of("/\\");
+    if(extension == std::string::npos || (separator != std::string::npos && extension < separator))
+    {
+        return image_path + ".tex";
+    }
+    return image_path.substr(0, extension) + ".tex";
+}
+
+bool WriteContainer(const std::string& image_path, const std::string& container_path)
+{
+    // Batch mode decodes on several threads, and the global flag isn't safe
+    stbi_set_flip_vertically_on_load_thread(true);
+    int width, height, num_channels;
+    unsigned char* data = stbi_load(image_path.c_str(), &width, &height, &num_channels, container_num_channels);
+    if(data == NULL)
+    {
+        printf("Failed to load %s: %s\n", image_path.c_str(), stbi_failure_reason());
+        return false;
+    }
+
+    std::vector<unsigned char> container;
+    WriteTextureContainer(data, width, height, container_num_channels, container);
+    stbi_image_free(data);
+
+    FILE* file = fopen(container_path.c_str(), "wb");
+    if(file == NULL)
+    {
+        printf("Unable to write %s\n", container_path.c_str());
+        return false;
+    }
+    bool written = fwrite(&container[0], 1, container.size(), file) == container.size();
+    fclose(file);
+
+    if(written)
+    {
+        printf("%s -> %s (%dx%d, %u bytes)\n", image_path.c_str(), container_path.c_str(),
+               width, height, (uint32_t)container.size());
+    }
+    return written;
+}
+
+bool HasExtension(const char* file_name, const char* extension)
+{
+    size_t name_length = strlen(file_name);
+    size_t extension_length = strlen(extension);
+    return name_length > extension_length && strcmp(file_name + name_length - extension_length, extension) == 0;
+}
+
+int WriteContainers(const char* directory_path)
+{
+    DIR* directory = opendir(directory_path);
+    if(directory == NULL)
+    {
+        printf("Unable to open %s\n", directory_path);
+        return 1;
+    }
+
+    std::vector<std::string> image_paths;
+    struct dirent* entry;
+    while((entry = readdir(directory)) != NULL)
+    {
+        if(HasExtension(entry->d_name, ".png") || HasExtension(entry->d_name, ".jpg"))
+        {
+            image_paths.push_back(std::string(directory_path) + "/" + entry->d_name);
+        }
+    }
+    closedir(directory);
+
+    // BrickTexture.png and BrickTexture.jpg would race to write BrickTexture.tex
+    std::vector<std::pair<std::string, std::string> > outputs;
+    for(uint32_t i = 0; i < image_paths.size(); i++)
+    {
+        outputs.push_back(std::make_pair(GetContainerPath(image_paths[i]), image_paths[i]));
+    }
+    std::sort(outputs.begin(), outputs.end());
+    bool has_duplicates = false;
+    for(uint32_t i = 1; i < outputs.size(); i++)
+    {
+        if(outputs[i].first == outputs[i - 1].first)
+        {
+            printf("%s and %s would both write %s\n", outputs[i - 1].second.c_str(), outputs[i].second.c_str(),
+                   outputs[i].first.c_str());
+            has_duplicates = true;
+        }
+    }
+    if(has_duplicates)
+    {
+        printf("Nothing converted, rename the images so each has its own container\n");
+        return 1;
+    }
+
+    // Each thread takes the next image until none are left
+    std::atomic<uint32_t> next_image(0);
+    std::atomic<uint32_t> num_failed(0);
+    uint32_t num_threads = std::thread::hardware_concurrency();
+    if(num_threads == 0)
+    {
+        num_threads = 1;
+    }
+
+    std::vector<std::thread> threads;
+    for(uint32_t i = 0; i < num_threads; i++)
+    {
+        threads.push_back(std::thread([&]()
+        {
+            uint32_t image_index;
+            while((image_index = next_image++) < image_paths.size())
+            {
+                const std::string& image_path = image_paths[image_index];
+                if(!WriteContainer(image_path, GetContainerPath(image_path)))
+                {
+                    num_failed++;
+                }
+            }
+        }));
+    }
+    for(uint32_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+
+    printf("Converted %u of %u images\n", (uint32_t)image_paths.size() - num_failed, (uint32_t)image_paths.size());
+    return num_failed == 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc >= 3 && strcmp(argv[1], "-c") == 0)
+    {
+        std::string container_path = argc >= 4 ? argv[3] : GetContainerPath(argv[2]);
+        return WriteContainer(argv[2], container_path) ? 0 : 1;
+    }
+    else if(argc >= 3 && strcmp(argv[1], "-b") == 0)
+    {
+        return WriteContainers(argv[2]);
+    }
+    else if(argc >= 2)
+    {
+        return WriteHeader(argv[1]);
+    }
+
+    printf("Usage: %s <image> | -c <image> [out.tex] | -b <directory>\n", argv[0]);
+    return 1;
+}